@@ -3,9 +3,30 @@
 CPP_FILE="main.cpp"
 OUT_FILE="run_model"
 
+# ./compile.sh static：只註冊模型用到的 op (MinimalOpResolver) 並靜態連結，輸出 run_model_static，
+# 執行時不需 libtensorflow-lite.so。需先以 -DBUILD_SHARED_LIBS=OFF 建 TFLite 到 build-static
+if [ "$1" == "static" ]; then
+  STATIC_DIR=$HOME/tensorflow/build-static
+  g++ -std=c++17 -O2 -DTFLITE_MINIMAL_OPS $CPP_FILE -o "${OUT_FILE}_static" \
+    -I$HOME/tensorflow                 \
+    -I$STATIC_DIR/flatbuffers/include  \
+    -Wl,--gc-sections -Wl,--start-group $(find "$STATIC_DIR" -name '*.a') -Wl,--end-group \
+    -static -lpthread -ldl
+  exit $?
+fi
+
+# ./compile.sh check：建 run_model 後以範例模型執行 --check (原生 MLP 對 TFLite)，超出容許差即以非 0 結束
+if [ "$1" == "check" ]; then
+  SAMPLE_DIR=../../../ar_wind_farm_dnn_exe_file/x86-setable-preds
+  MODEL=$SAMPLE_DIR/ar_dnn-w10-l16-l32-l16_windfarm_0620
+  bash "$0" || exit 1
+  ./"${OUT_FILE}" --check -m "$MODEL.tflite" -s "$MODEL-std-mean.csv" -i "$SAMPLE_DIR/input-dnn.csv" ${2:+--tolerance=$2}
+  exit $?
+fi
+
 # 共享庫 libtensorflow-lite.so 需在當前資料夾
 g++ -std=c++17 $CPP_FILE -o "${OUT_FILE}" \
   -I$HOME/tensorflow                 \
   -L$HOME/tensorflow/build-shared    \
   -ltensorflow-lite -lpthread \
-  -Wl,-rpath=.
\ No newline at end of file
+  -Wl,-rpath=.
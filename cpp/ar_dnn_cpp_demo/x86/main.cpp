@@ -1,7 +1,3 @@
-#include "tensorflow/lite/interpreter.h"
-#include "tensorflow/lite/kernels/register.h"
-#include "tensorflow/lite/model.h"
-
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -10,28 +6,31 @@
 #include <sstream>
 #include <string>
 #include <limits>
+#include <algorithm>
+#include <chrono>
+#include <thread>
+#include <sys/resource.h>
+
+#include "../../common/csv_reader.h"
+#ifdef TFLITE_MINIMAL_OPS
+#include "../../common/ar_dnn_op_resolver.h"   // 靜態連結版：只註冊模型用到的 op
+#endif
+#include "../../common/tflite_models.h"
 
 
 
 /******************************
  *  Utilities                 *
  ******************************/
-// 讀取一維數據 CSV (每行一個浮點數)
-std::vector<float> read_csv(const std::string& csv_path) {
+// 只讀檔尾最後 n 筆 (mmap 後自檔尾往前找，讀取量與檔案大小無關)
+std::vector<float> read_csv_tail(const std::string& csv_path, size_t n) {
     std::vector<float> data;
-    std::ifstream file(csv_path);
-    if (!file.is_open()) {
+    CsvStats st;
+    if (!csv_read_tail(csv_path, n, data, CsvOptions{}, &st)) {
         std::cerr << "Cannot open the CSV file: " << csv_path << std::endl;
         exit(1);
     }
-    std::string line;
-    while (std::getline(file, line)) {
-        try {
-            data.push_back(std::stof(line));
-        } catch (const std::invalid_argument&) {
-            std::cerr << "CSV file contains an invalid data: " << line << std::endl;
-        }
-    }
+    if (st.invalid) std::cerr << "CSV file contains " << st.invalid << " invalid line(s): " << csv_path << std::endl;
     return data;
 }
 
@@ -76,11 +75,221 @@ Stats read_stats(const std::string& csv_path) {
     return s;
 }
 
+/* --bench：同一段歷史分別以原生 MLP 與 TFLite 直譯器預測 n_steps 步，
+ * 各自重複到至少 0.5 秒，比較每步延遲與兩者輸出的最大差異 */
+int run_bench(NativeMlp& native, TfliteModel& model, const Stats& stats,
+              const std::vector<float>& history, int n_steps) {
+    ArDnnForecaster fc_native, fc_tflite;
+    if (!fc_native.init(native, stats.mean, stats.std) || !fc_tflite.init(model, stats.mean, stats.std)) return 1;
+    std::vector<float> pred_native(std::max(n_steps, 1)), pred_tflite(pred_native.size());
+
+    auto time_per_step = [&](ArDnnForecaster& fc, std::vector<float>& out) -> double {
+        using clock = std::chrono::steady_clock;
+        if (!fc.forecast(history, out)) return -1.0;         // 暖機
+        size_t reps = 0;
+        const auto t0 = clock::now();
+        double sec = 0.0;
+        do {
+            if (!fc.forecast(history, out)) return -1.0;
+            ++reps;
+            sec = std::chrono::duration<double>(clock::now() - t0).count();
+        } while (sec < 0.5 || reps < 3);
+        return sec / (double(reps) * out.size());
+    };
+    const double t_native = time_per_step(fc_native, pred_native);
+    const double t_tflite = time_per_step(fc_tflite, pred_tflite);
+    if (t_native < 0 || t_tflite < 0) return 1;
+
+    float max_diff = 0.f;
+    for (size_t k = 0; k < pred_native.size(); ++k)
+        max_diff = std::max(max_diff, std::fabs(pred_native[k] - pred_tflite[k]));
+    std::cout << "native (" << native.kernel_name() << "): " << t_native * 1e6 << " us/step\n"
+              << "tflite interpreter: " << t_tflite * 1e6 << " us/step\n"
+              << "speedup: " << t_tflite / t_native << "x, max |native - tflite| over "
+              << pred_native.size() << " steps = " << max_diff << std::endl;
+    return 0;
+}
+
+/* --check：同一段歷史以原生 MLP 與 TFLite 直譯器各預測 n_steps 步，逐步比較輸出；
+ * 最大絕對差超過 tolerance (原始單位，預設 1e-4 × std，即標準化後 1e-4) 時以 1 結束。
+ * 原生引擎使用 FMA，累加順序也與 TFLite 不同，因此只要求在 float32 捨入的量級內一致 */
+int run_check(NativeMlp& native, TfliteModel& model, const Stats& stats,
+              const std::vector<float>& history, int n_steps, float tolerance) {
+    ArDnnForecaster fc_native, fc_tflite;
+    if (!fc_native.init(native, stats.mean, stats.std) || !fc_tflite.init(model, stats.mean, stats.std)) return 1;
+    std::vector<float> pred_native(std::max(n_steps, 1)), pred_tflite(pred_native.size());
+    if (!fc_native.forecast(history, pred_native) || !fc_tflite.forecast(history, pred_tflite)) return 1;
+
+    if (!(tolerance > 0.f)) tolerance = 1e-4f * stats.std;
+    float max_diff = 0.f;
+    size_t worst = 0;
+    for (size_t k = 0; k < pred_native.size(); ++k) {
+        const float diff = std::fabs(pred_native[k] - pred_tflite[k]);
+        if (!(diff <= max_diff)) { max_diff = diff; worst = k; }        // NaN 也視為最差
+    }
+    const bool ok = max_diff <= tolerance;
+    std::cout << "check: native (" << native.kernel_name() << ") vs tflite over " << pred_native.size()
+              << " steps, max |diff| = " << max_diff << " at step " << worst + 1
+              << ", tolerance = " << tolerance << (ok ? " -> PASS" : " -> FAIL") << std::endl;
+    return ok ? 0 : 1;
+}
+
+/* --batch：--input 為每台風機一欄的 CSV (可有表頭)，N 條序列同步預測 n_steps 步，
+ * 輸出每欄一條序列、每列一步。加 --bench 時改為量測批次大小 1, 2, 4, … N 的吞吐量 */
+int run_batch(NativeMlp* native, TfliteModel* tflite, const Stats& stats,
+              const std::string& input_path, const std::string& output_path, int n_steps, bool bench) {
+    std::vector<std::string> names;
+    std::vector<std::vector<float>> cols;
+    if (!csv_read_columns(input_path, names, cols) || cols.empty()) {
+        std::cerr << "No series found in " << input_path << std::endl;
+        return 1;
+    }
+    if (names.size() != cols.size()) {
+        names.clear();
+        for (size_t c = 0; c < cols.size(); ++c) names.push_back("s" + std::to_string(c));
+    }
+    const int n = int(cols.size());
+    n_steps = std::max(n_steps, 1);
+    std::vector<Span<const float>> histories(cols.begin(), cols.end());
+
+    auto init = [&](ArDnnBatchForecaster& fc, bool use_native, int batch) {
+        return use_native ? fc.init(*native, batch, stats.mean, stats.std)
+                          : fc.init(*tflite, batch, stats.mean, stats.std);
+    };
+
+    if (!bench) {
+        ArDnnBatchForecaster fc;
+        if (!init(fc, native != nullptr, n)) return 1;
+        std::vector<float> out(size_t(n_steps) * n);
+        const auto t0 = std::chrono::steady_clock::now();
+        if (!fc.forecast(histories, out)) return 1;
+        const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+        std::ofstream file(output_path);
+        if (!file.is_open()) { std::cerr << "Cannot output CSV file: " << output_path << std::endl; return 1; }
+        for (int s = 0; s < n; ++s) file << names[s] << (s + 1 < n ? "," : "\n");
+        for (size_t k = 0; k < out.size(); ++k) file << out[k] << ((k + 1) % n ? "," : "\n");
+        std::cout << "series: " << n << ", forecast time: " << sec * 1e3 << " ms ("
+                  << (sec > 0 ? n / sec : 0.0) << " series/s)\n"
+                  << "Predictions saved to: " << output_path << std::endl;
+        return 0;
+    }
+
+    // 吞吐量：可用的引擎各自對每個批次大小取前 batch 條序列，重複預測到至少 0.3 秒
+    std::vector<int> sizes;
+    for (int b = 1; b < n; b *= 2) sizes.push_back(b);
+    sizes.push_back(n);
+    std::vector<bool> engines;
+    if (native) engines.push_back(true);
+    if (tflite) engines.push_back(false);
+    std::vector<std::vector<float>> full(engines.size());    // 各引擎 batch = n 的輸出，供比對
+    std::cout << "engine,batch,us_per_step,ns_per_series_step,series_steps_per_s\n";
+    for (size_t e = 0; e < engines.size(); ++e) {
+        for (const int batch : sizes) {
+            ArDnnBatchForecaster fc;
+            if (!init(fc, engines[e], batch)) return 1;
+            std::vector<Span<const float>> part(histories.begin(), histories.begin() + batch);
+            std::vector<float> out(size_t(n_steps) * batch);
+            if (!fc.forecast(part, out)) return 1;          // 暖機
+            size_t reps = 0;
+            const auto t0 = std::chrono::steady_clock::now();
+            double sec = 0.0;
+            do {
+                if (!fc.forecast(part, out)) return 1;
+                ++reps;
+                sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            } while (sec < 0.3 || reps < 3);
+            const double per_step = sec / (double(reps) * n_steps);
+            std::cout << (engines[e] ? "native" : "tflite") << "," << batch << "," << per_step * 1e6 << ","
+                      << per_step / batch * 1e9 << "," << batch / per_step << "\n";
+            if (batch == n) full[e] = out;
+        }
+    }
+    if (engines.size() == 2) {
+        float max_diff = 0.0f;
+        for (size_t k = 0; k < full[0].size(); ++k) max_diff = std::max(max_diff, std::abs(full[0][k] - full[1][k]));
+        std::cout << "max |native - tflite| over " << n << " series x " << n_steps << " steps: " << max_diff << "\n";
+    }
+    std::cout.flush();
+    return 0;
+}
+
+/* --autotune：以 TFLite 直譯器在實際的輸入形狀 ([1, window]，--batch 時 [N, window]) 上
+ * 量測每個 (委派, 執行緒數) 組合的 Invoke 耗時，最快的組合寫入 tune_path 後結束 */
+int run_autotune(TfliteModel& model, const Stats& stats, const std::string& input_path,
+                 bool batch, const std::string& tune_path) {
+    const TfLiteTensor* in = model.input();
+    const int input_len = in->dims->data[in->dims->size - 1];
+    std::vector<std::vector<float>> series;
+    if (batch) {
+        std::vector<std::string> names;
+        if (!csv_read_columns(input_path, names, series) || series.empty()) {
+            std::cerr << "No series found in " << input_path << std::endl;
+            return 1;
+        }
+    } else {
+        series.push_back(read_csv_tail(input_path, static_cast<size_t>(input_len)));
+    }
+    const int n = int(series.size());
+
+    // 每次重建直譯器後設定形狀，並寫入各序列最後 input_len 個標準化值 (不足補 0)
+    auto prepare = [&](TfliteModel& m) -> bool {
+        if (n > 1 && !m.resize_input({n, input_len})) return false;
+        TfLiteTensor* t = m.input();
+        for (int s = 0; s < n; ++s) {
+            const std::vector<float>& h = series[s];
+            for (int j = 0; j < input_len; ++j) {
+                const int k = int(h.size()) - input_len + j;
+                const float z = k >= 0 ? (h[k] - stats.mean) / stats.std : 0.f;
+                if (t->type == kTfLiteFloat32) m.interpreter()->typed_tensor<float>(m.input_index())[s * input_len + j] = z;
+                else m.interpreter()->typed_tensor<int8_t>(m.input_index())[s * input_len + j] = tflite_quantize(z, t);
+            }
+        }
+        return true;
+    };
+
+    std::vector<TfliteTuneResult> results;
+    if (!tflite_autotune(model, prepare, int(std::max(1u, std::thread::hardware_concurrency())), results)) return 1;
+    const std::string shape = std::to_string(n) + "x" + std::to_string(input_len);
+    std::cout << "input shape: " << shape << "\ndelegate,threads,us_per_invoke\n";
+    for (const TfliteTuneResult& r : results)
+        std::cout << tflite_delegate_name(r.options.delegate) << "," << r.options.threads << "," << r.us_per_invoke << "\n";
+    if (!write_tflite_options(tune_path, results[0].options, shape, results[0].us_per_invoke)) return 1;
+    std::cout << "Fastest: delegate=" << tflite_delegate_name(results[0].options.delegate)
+              << ", threads=" << results[0].options.threads << " → saved to " << tune_path << std::endl;
+    return 0;
+}
+
+/* --startup-report：程序從 main 開始到輸出完成的時間與峰值 RSS，
+ * 供 cpp/tools/startup_report.sh 比較動態連結與靜態連結 (最小 op resolver) 版 */
+void print_startup_report(std::chrono::steady_clock::time_point t_main) {
+    struct rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_main).count();
+#ifdef TFLITE_MINIMAL_OPS
+    const char* resolver = "minimal";
+#else
+    const char* resolver = "builtin";
+#endif
+    std::cout << "startup_report: resolver=" << resolver << ", main_ms=" << ms
+              << ", peak_rss_kb=" << ru.ru_maxrss << std::endl;
+}
+
 /******************************
  *  Main                      *
  ******************************/
 int main(int argc, char* argv[]) {
+    const auto t_main = std::chrono::steady_clock::now();
     std::string model_path, input_path, output_path, stats_path;
+    std::string engine = "tflite";   // auto：原生 MLP 可用時使用，否則 TFLite；尚未在實際 TFLite 上比對前預設不用原生
+    bool bench = false;
+    bool batch = false;
+    bool autotune = false;
+    bool startup_report = false;
+    bool check = false;
+    float tolerance = 0.f;                // --check 的容許差；0 = 1e-4 × std
+    std::string delegate_arg, tune_path;
+    int threads = 0;
     int n_steps = 25;
 
     // --- CLI 參數解析 --- //
@@ -104,97 +313,113 @@ int main(int argc, char* argv[]) {
         else if (arg.rfind("--stats_path=",0)==0)       stats_path = arg.substr(13);
         else if (arg == "-n" || arg == "--n_steps")      n_steps = std::stoi(read_next(arg));
         else if (arg.rfind("--n_steps=",0)==0)          n_steps = std::stoi(arg.substr(10));
+        else if (arg.rfind("--engine=",0)==0)           engine = arg.substr(9);
+        else if (arg == "--bench")                      bench = true;
+        else if (arg == "--batch")                      batch = true;
+        else if (arg.rfind("--delegate=",0)==0)         delegate_arg = arg.substr(11);
+        else if (arg.rfind("--threads=",0)==0)          threads = std::stoi(arg.substr(10));
+        else if (arg == "--autotune")                   autotune = true;
+        else if (arg.rfind("--tune-file=",0)==0)        tune_path = arg.substr(12);
+        else if (arg == "--startup-report")             startup_report = true;
+        else if (arg == "--check")                      check = true;
+        else if (arg.rfind("--tolerance=",0)==0)        tolerance = std::stof(arg.substr(12));
     }
 
+    if (check && output_path.empty()) output_path = "/dev/null";          // --check 不寫預測
     if (model_path.empty() || input_path.empty() || output_path.empty() || stats_path.empty()) {
-        std::cerr << "Usage: ./run_model -m <model.tflite> -i <history.csv> -o <preds.csv> -s <stats.csv> -n <steps>\n";
+        std::cerr << "Usage: ./run_model -m <model.tflite> -i <history.csv> -o <preds.csv> -s <stats.csv> -n <steps>\n"
+                     "       [--engine=tflite|native|auto] (default tflite) native (experimental) runs the dense layers without the\n"
+                     "       TFLite interpreter, --bench compares its per-step latency with TFLite\n"
+                     "       [--check [--tolerance=X]] runs both engines and fails if they differ by more than X (default 1e-4 x std)\n"
+                     "       [--batch] forecasts every column of the input CSV in lock-step (one Invoke per step),\n"
+                     "       --batch --bench reports throughput against batch size for both engines\n"
+                     "       [--delegate=default|xnnpack|none --threads=N] TFLite interpreter settings,\n"
+                     "       --autotune times every setting and saves the fastest to --tune-file (default <model>-tune.csv)\n"
+                     "       [--startup-report] prints time from main() to done and peak RSS (every mode)\n";
+        return 1;
+    }
+    if (engine != "auto" && engine != "native" && engine != "tflite") {
+        std::cerr << "--engine must be auto, native or tflite" << std::endl;
+        return 1;
+    }
+    if (check && (batch || autotune)) {
+        std::cerr << "--check runs a single series and cannot be combined with --batch or --autotune" << std::endl;
         return 1;
     }
 
+    // --- TFLite 設定：先讀 --autotune 存下的設定檔，命令列參數再覆寫 --- //
+    TfliteOptions tfl_opts;
+    if (tune_path.empty()) tune_path = tflite_tune_path(model_path);
+    const bool tuned = !autotune && read_tflite_options(tune_path, tfl_opts);
+    if (!delegate_arg.empty() && !parse_tflite_delegate(delegate_arg, tfl_opts.delegate)) {
+        std::cerr << "--delegate must be default, xnnpack or none" << std::endl;
+        return 1;
+    }
+    if (threads > 0) tfl_opts.threads = threads;
+
     std::cout << "model_path   : " << model_path << "\n"
               << "input_path   : " << input_path << "\n"
               << "output_path  : " << output_path << "\n"
               << "stats_path   : " << stats_path << "\n"
-              << "n_steps      : " << n_steps << "\n";
+              << "n_steps      : " << n_steps << "\n"
+              << "tflite       : delegate=" << tflite_delegate_name(tfl_opts.delegate) << ", threads=" << tfl_opts.threads
+              << (tuned ? " (from " + tune_path + ")" : std::string()) << "\n";
 
-    // --- 讀取歷史數據與統計量 --- //
-    std::vector<float> history = read_csv(input_path);
+    // --- 讀取統計量 (歷史數據待得知 input_len 後只讀檔尾) --- //
     Stats stats = read_stats(stats_path);
     std::cout << "mean=" << stats.mean << ", std=" << stats.std << "\n";
 
-    // --- 載入 TFLite 模型 --- //
-    auto model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
-    if (!model) { std::cerr << "Failed to load model\n"; return 1; }
-
-    tflite::ops::builtin::BuiltinOpResolver resolver;
-    std::unique_ptr<tflite::Interpreter> interpreter;
-    tflite::InterpreterBuilder(*model, resolver)(&interpreter);
-    if (!interpreter) { std::cerr << "Failed to construct interpreter\n"; return 1; }
-    if (interpreter->AllocateTensors() != kTfLiteOk) { std::cerr << "AllocateTensors failed\n"; return 1; }
-
-    // --- 取得輸入 tensor 長度 (滑動窗口大小) --- //
-    const int input_index = interpreter->inputs()[0];
-    TfLiteTensor* input_tensor = interpreter->tensor(input_index);
-    if (input_tensor->dims->size < 1) { std::cerr << "Invalid input tensor dims\n"; return 1; }
-    const int input_len = input_tensor->dims->data[input_tensor->dims->size - 1];
-    if (input_len <= 0) { std::cerr << "Input length must be > 0\n"; return 1; }
-
-    // --- 歷史數據需足夠 --- //
-    if (history.size() < static_cast<size_t>(input_len)) {
-        std::cerr << "History size (" << history.size() << ") is smaller than input_len (" << input_len << ")\n";
+    // --- 載入模型：先試原生 MLP (只含 FullyConnected 時可用)，否則退回 TFLite 直譯器 --- //
+    NativeMlp native;
+    TfliteModel model;
+    ArDnnForecaster forecaster;
+    auto finish = [&](int rc) {                     // 每條路徑結束時都輸出 --startup-report
+        if (startup_report) print_startup_report(t_main);
+        return rc;
+    };
+    if (autotune) {
+        if (!model.load_file(model_path, tfl_opts)) return 1;
+        return finish(run_autotune(model, stats, input_path, batch, tune_path));
+    }
+    // --bench / --check 比較兩個引擎，因此不論 --engine 都試載原生 MLP
+    const bool both = bench || check;
+    const bool native_ok = (engine != "tflite" || both) && native.load_file(model_path);
+    const bool use_native = engine != "tflite" && native_ok;
+    if (engine == "native" && !use_native) return 1;
+    if (engine == "auto" && !use_native) std::cerr << "Falling back to the TFLite interpreter" << std::endl;
+    if ((!use_native || both) && !model.load_file(model_path, tfl_opts)) return 1;
+    std::cout << "engine       : " << (use_native ? "native (" + native.kernel_name() + ")" : std::string("tflite")) << "\n";
+    if (batch) {
+        // 批次張量為 [N, window] float32；量化模型在讀取輸入前就拒絕
+        if ((!use_native || bench) &&
+            (model.input()->type != kTfLiteFloat32 || model.output()->type != kTfLiteFloat32)) {
+            std::cerr << "--batch supports float32 models only; " << model_path
+                      << " has a quantized (non-float32) input or output tensor, run it without --batch" << std::endl;
+            return 1;
+        }
+        if (bench) return finish(run_batch(native_ok ? &native : nullptr, &model, stats, input_path, output_path, n_steps, true));
+        return finish(run_batch(use_native ? &native : nullptr, use_native ? nullptr : &model, stats,
+                                input_path, output_path, n_steps, false));
+    }
+    if (both && !native_ok) {
+        std::cerr << (check ? "--check" : "--bench") << " needs a model the native engine can run" << std::endl;
         return 1;
     }
+    if (use_native ? !forecaster.init(native, stats.mean, stats.std)
+                   : !forecaster.init(model, stats.mean, stats.std)) return 1;
+    const int input_len = forecaster.input_len();
 
-    // --- 初始化滑動窗口 (最後 input_len 筆) --- //
-    std::vector<float> window(history.end() - input_len, history.end());
-    std::vector<float> predictions;
-
-    // --- 預測 n_steps 次 --- //
-    for (int step = 0; step < n_steps; ++step) {
-        // 1) 將 window 標準化後寫入輸入張量
-        if (input_tensor->type == kTfLiteFloat32) {
-            float* in = interpreter->typed_tensor<float>(input_index);
-            for (int j = 0; j < input_len; ++j) {
-                in[j] = (window[j] - stats.mean) / stats.std;
-            }
-        } else if (input_tensor->type == kTfLiteInt8) {
-            int8_t* in = interpreter->typed_tensor<int8_t>(input_index);
-            float scale = input_tensor->params.scale;
-            int32_t zero_pt = input_tensor->params.zero_point;
-            for (int j = 0; j < input_len; ++j) {
-                float norm_val = (window[j] - stats.mean) / stats.std;           // 標準化
-                int32_t quant = static_cast<int32_t>(std::round(norm_val / scale) + zero_pt);
-                quant = std::min<int32_t>(std::max<int32_t>(quant, std::numeric_limits<int8_t>::min()), std::numeric_limits<int8_t>::max());
-                in[j] = static_cast<int8_t>(quant);
-            }
-        } else {
-            std::cerr << "Unsupported input tensor type\n"; return 1; }
-
-        // 2) 執行推理
-        if (interpreter->Invoke() != kTfLiteOk) { std::cerr << "Inference failed\n"; return 1; }
+    // --- 歷史數據：只讀最後 input_len 筆，且需足夠 --- //
+    std::vector<float> history = read_csv_tail(input_path, static_cast<size_t>(input_len));
+    if (check) return finish(run_check(native, model, stats, history, n_steps, tolerance));
+    if (bench) return finish(run_bench(native, model, stats, history, n_steps));
 
-        // 3) 讀取輸出 (標準化值) 並還原
-        const int output_index = interpreter->outputs()[0];
-        TfLiteTensor* out_tensor = interpreter->tensor(output_index);
-        float pred_std = 0.f;
-        if (out_tensor->type == kTfLiteFloat32) {
-            pred_std = interpreter->typed_tensor<float>(output_index)[0];
-        } else if (out_tensor->type == kTfLiteInt8) {
-            int8_t q = interpreter->typed_tensor<int8_t>(output_index)[0];
-            pred_std = (static_cast<int32_t>(q) - out_tensor->params.zero_point) * out_tensor->params.scale;
-        } else {
-            std::cerr << "Unsupported output tensor type\n"; return 1; }
-
-        float pred = pred_std * stats.std + stats.mean;  // 反標準化
-        predictions.push_back(pred);
-
-        // 4) 更新滑動窗口
-        window.erase(window.begin());      // 移除最舊值
-        window.push_back(pred);            // 加入新預測 (原始尺度)
-    }
+    // --- 預測 n_steps 次 (滑動窗口自迴歸) --- //
+    std::vector<float> predictions(std::max(n_steps, 0));
+    if (!forecaster.forecast(history, predictions)) return 1;
 
     // --- 寫入結果 --- //
     write_csv(output_path, predictions);
     std::cout << "Predictions saved to: " << output_path << std::endl;
-    return 0;
+    return finish(0);
 }
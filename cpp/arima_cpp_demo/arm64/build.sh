@@ -3,6 +3,14 @@ set -e
 
 BUILD_DIR=build_aarch64
 
+# ./build.sh check：建 run_model_check 並執行配置檢查 (alloc_check 目標)，預測器有任何配置即失敗
+if [ "$1" == "check" ]; then
+    cmake -S . -B "$BUILD_DIR" -DCMAKE_BUILD_TYPE=Release
+    cmake --build "$BUILD_DIR" --target alloc_check -j"$(nproc)"
+    echo "✅ 配置檢查通過"
+    exit 0
+fi
+
 echo "▶ 清理並建立 $BUILD_DIR"
 rm -rf "$BUILD_DIR"
 
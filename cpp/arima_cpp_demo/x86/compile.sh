@@ -3,4 +3,13 @@
 CPP_FILE="main.cpp"
 OUT_FILE="run_model"
 
-g++ -std=c++17 -O3 $CPP_FILE -o $OUT_FILE
\ No newline at end of file
+# ./compile.sh check [model.csv] [input.csv]：以計數配置器 (-DARIMA_ALLOC_CHECK) 建 run_model_check，
+# 並執行 --alloc-check；預測器建好後只要有任何配置或結果與 arima_forecast() 不同即以非 0 結束
+if [ "$1" == "check" ]; then
+  SAMPLE_DIR=../../../ar_wind_farm_arima_exe_file/x86-setable-preds
+  g++ -std=c++17 -O3 -pthread -DARIMA_ALLOC_CHECK $CPP_FILE -o "${OUT_FILE}_check" || exit 1
+  ./"${OUT_FILE}_check" --alloc-check --model="${2:-$SAMPLE_DIR/model.csv}" --input="${3:-$SAMPLE_DIR/input.csv}"
+  exit $?
+fi
+
+g++ -std=c++17 -O3 -pthread $CPP_FILE -o $OUT_FILE
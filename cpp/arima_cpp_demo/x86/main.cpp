@@ -4,146 +4,932 @@
 #include <vector>
 #include <iostream>
 #include <string>
+#include <algorithm>
+#include <chrono>
+#include <filesystem>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <limits>
+#include <thread>
 
-// 讀取 ARIMA 權重
-std::unordered_map<std::string, double> load_arima_model(const std::string& filename) {
-    std::unordered_map<std::string, double> model;
-    std::ifstream file(filename);
-    std::string line;
-    while (std::getline(file, line)) {
-        size_t comma = line.find(',');
-        if (comma == std::string::npos) continue;
-        std::string key = line.substr(0, comma);
-        double val = std::stod(line.substr(comma + 1));
-        model[key] = val;
-    }
-    return model;
+#include "../../common/csv_reader.h"
+#include "../../common/arima.h"
+#include "../../common/arima_batch.h"
+#include "../../common/arima_fit.h"
+#include "../../common/arima_fixed.h"
+#include "../../common/arima_hierarchy.h"
+#include "../../common/arima_horizon.h"
+#include "../../common/arima_kalman.h"
+#include "../../common/arima_sarimax.h"
+
+#ifdef ARIMA_ALLOC_CHECK
+/* 以 -DARIMA_ALLOC_CHECK 編譯時替換全域 operator new 計數配置次數，
+ * 供 --alloc-check 驗證 ArimaForecaster 建構後的預測不配置記憶體 */
+#include <cstdlib>
+#include <new>
+#pragma GCC diagnostic ignored "-Wmismatched-new-delete"   // malloc/free 配對本身正確，GCC inline 後誤報
+static std::atomic<size_t> g_alloc_count{0};
+void* operator new(size_t size) {
+    g_alloc_count.fetch_add(1, std::memory_order_relaxed);
+    if (void* ptr = std::malloc(size ? size : 1)) return ptr;
+    throw std::bad_alloc();
 }
+void operator delete(void* ptr) noexcept { std::free(ptr); }
+void operator delete(void* ptr, size_t) noexcept { std::free(ptr); }
+#endif
 
-// 讀取歷史資料
+// 讀取歷史資料 (共用 csv_reader.h：跳過空行，第一行若不是數字視為 header)
 std::vector<double> load_history(const std::string& filename) {
     std::vector<double> vals;
-    std::ifstream file(filename);
-    std::string line;
-    while (std::getline(file, line)) {
-        // 跳過空行
-        if (line.empty()) continue;
-        // 處理若有header，若第一行不是數字則跳過
+    csv_read_column(filename, vals);
+    return vals;
+}
+
+/* 開啟只用 view 的路徑 (批次、Kalman、回測…) 的模型：
+ * 季節 / 外生變數模型只有單序列預測支援，其餘路徑一律拒絕 */
+bool open_plain_model(const std::string& filename, ArimaModelHandle& h) {
+    if (!open_arima_model(filename, h)) return false;
+    if (h.extended()) {
+        std::cerr << "Error: " << filename << " has seasonal or exogenous terms, which only the single-series forecast supports\n";
+        return false;
+    }
+    return true;
+}
+
+// 只讀檔尾最後 n 筆有效數值 (mmap 後自檔尾往前找)；讀取量與檔案大小無關
+std::vector<double> load_history_tail(const std::string& filename, size_t n) {
+    std::vector<double> vals;
+    csv_read_tail(filename, n, vals);
+    return vals;
+}
+
+
+// "1,60,900,21600" → {1, 60, 900, 21600}；horizon 須 ≥ 1
+bool parse_horizons(const std::string& text, std::vector<long>& horizons) {
+    std::stringstream ss(text);
+    std::string field;
+    while (std::getline(ss, field, ',')) {
         try {
-            vals.push_back(std::stod(line));
+            long h = std::stol(field);
+            if (h < 1) throw std::out_of_range("horizon");
+            horizons.push_back(h);
         } catch (...) {
-            continue;
+            std::cerr << "Error: invalid horizon '" << field << "'\n";
+            return false;
         }
     }
-    return vals;
+    return !horizons.empty();
 }
 
+int run_horizons(const std::string& model_path, const std::string& input_path,
+                 const std::string& output_path, const std::vector<long>& horizons, bool verify) {
+    ArimaModelHandle model;
+    if (!open_plain_model(model_path, model)) return 1;
+    auto history = load_history_tail(input_path, size_t(std::max(model.view.p + model.view.d, 1)));
+    ArimaForecaster f;
+    if (!f.init(model.view, history.data(), history.size())) return 1;
+
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<double> out(horizons.size());
+    arima_forecast_horizons(f, horizons, out);
+    double us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+
+    std::ofstream file(output_path);
+    for (size_t i = 0; i < horizons.size(); ++i) file << horizons[i] << "," << out[i] << "\n";
+    std::cout << "jump-ahead  : " << us << " us for " << horizons.size() << " horizons" << std::endl;
+
+    if (verify) {                                  // 與逐步遞迴比對
+        const long h_max = *std::max_element(horizons.begin(), horizons.end());
+        std::vector<double> seq(h_max);
+        t0 = std::chrono::steady_clock::now();
+        f.forecast(seq.data(), int(h_max));
+        us = std::chrono::duration<double, std::micro>(std::chrono::steady_clock::now() - t0).count();
+        double max_rel = 0.0;
+        for (size_t i = 0; i < horizons.size(); ++i) {
+            const double ref = seq[horizons[i] - 1];
+            max_rel = std::max(max_rel, std::abs(out[i] - ref) / std::max(1.0, std::abs(ref)));
+        }
+        std::cout << "iterative   : " << us << " us for " << h_max << " steps\n"
+                  << "max rel diff: " << max_rel << std::endl;
+        if (max_rel > 1e-9) { std::cerr << "Error: jump-ahead differs from iterative path\n"; return 1; }
+    }
+    return 0;
+}
+
+// 時間戳 → 秒：純數字 (epoch 或任意相對秒數)，或 "YYYY-MM-DD[ T]HH:MM:SS[.fff]" (視為 UTC)
+bool parse_timestamp(const char* b, const char* e, double& sec) {
+    while (b < e && (*b == ' ' || *b == '"')) ++b;
+    while (e > b && (e[-1] == ' ' || e[-1] == '"')) --e;
+    const std::string s(b, e);
+    int Y, M, D, h = 0, mi = 0, n = 0;
+    double ss = 0.0;
+    if (std::sscanf(s.c_str(), "%d-%d-%d%n", &Y, &M, &D, &n) == 3 && n >= 8) {
+        if (n < int(s.size()) && std::sscanf(s.c_str() + n + 1, "%d:%d:%lf", &h, &mi, &ss) < 2) return false;
+        /* days_from_civil (proleptic Gregorian) */
+        Y -= M <= 2;
+        const long era = (Y >= 0 ? Y : Y - 399) / 400;
+        const long yoe = Y - era * 400;
+        const long doy = (153 * (M + (M > 2 ? -3 : 9)) + 2) / 5 + D - 1;
+        const long days = era * 146097 + yoe * 365 + yoe / 4 - yoe / 100 + doy - 719468;
+        sec = double(days) * 86400.0 + h * 3600.0 + mi * 60.0 + ss;
+        return true;
+    }
+    const char* end = csv_parse_number(s.data(), s.data() + s.size(), sec);
+    return end && std::isfinite(sec);
+}
+
+// 通用 vs 特化每步耗時 (兩者輸出須完全相同)，以及 model.csv vs model.bin 載入時間
+int run_kernel_bench(const std::string& model_path, const std::string& input_path, int n_steps) {
+    auto model = load_arima_model(model_path);
+    auto history = load_history(input_path);
+    ArimaParams params;
+    if (!parse_arima_params(model, params)) return 1;
+    if (params.extended()) {
+        std::cerr << "Error: --bench does not support seasonal or exogenous models\n";
+        return 1;
+    }
+    const ArimaModelView m = view_of(params);
+    ArimaKernel fn = find_arima_kernel(m.p, m.d, m.q);
+    if (!fn) {
+        std::cerr << "No specialized kernel for p" << m.p << "d" << m.d << "q" << m.q << '\n';
+        return 1;
+    }
+
+    n_steps = std::max(n_steps, 1);
+    const int reps = std::max(1, 2000000 / n_steps);
+    std::vector<double> a, b(n_steps);
+    volatile double sink = 0.0;
+    auto time_ns_per_step = [&](auto&& body) {
+        auto t0 = std::chrono::steady_clock::now();
+        for (int r = 0; r < reps; ++r) body();
+        double ns = std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - t0).count();
+        return ns / (double(reps) * n_steps);
+    };
+    /* 三條路徑都從同一段歷史重建狀態再預測 n_steps 步：
+     * legacy = arima_forecast() (每次查 map、配置)，generic = 預先配置的 ArimaForecaster
+     * (reset + forecast，不配置)，specialized = 編譯期階數核心。speedup 只比後兩者 */
+    ArimaForecaster f;
+    if (!f.init(m, history.data(), history.size())) return 1;
+    std::vector<double> g(n_steps);
+    double t_legacy = time_ns_per_step([&] {
+        a.clear(); arima_forecast(model, history, n_steps, a); sink = sink + a.back();
+    });
+    double t_generic = time_ns_per_step([&] {
+        f.reset(history.data(), history.size()); f.forecast(g.data(), n_steps); sink = sink + g[n_steps - 1];
+    });
+    double t_fixed = time_ns_per_step([&] {
+        fn(m, history, b); sink = sink + b.back();
+    });
+
+    double max_diff = 0.0;
+    for (size_t i = 0; i < b.size(); ++i) {
+        if (i < a.size()) max_diff = std::max(max_diff, std::abs(a[i] - b[i]));
+        max_diff = std::max(max_diff, std::abs(g[i] - b[i]));
+    }
+    std::cout << "order       : p" << m.p << "d" << m.d << "q" << m.q << ", n_steps=" << n_steps << ", reps=" << reps << '\n'
+              << "legacy      : " << t_legacy  << " ns/step (arima_forecast, map lookups + allocation)\n"
+              << "generic     : " << t_generic << " ns/step (ArimaForecaster, allocation-free)\n"
+              << "specialized : " << t_fixed   << " ns/step\n"
+              << "speedup     : " << t_generic / t_fixed << "x over generic\n"
+              << "max |diff|  : " << max_diff << std::endl;
+
+    /* 冷載入：同一模型轉成 .bin 後比較單次載入成本；暫存檔名唯一，同時執行的 bench 不互相覆寫 */
+    std::string bin_path = (std::filesystem::temp_directory_path() / "arima_bench_XXXXXX.bin").string();
+    const int tmp_fd = mkstemps(bin_path.data(), 4);
+    if (tmp_fd < 0) { std::cerr << "Cannot create a temporary model file\n"; return 1; }
+    ::close(tmp_fd);
+    if (!write_arima_bin(bin_path, params)) { std::filesystem::remove(bin_path); return 1; }
+    const int load_reps = 2000;
+    auto t0 = std::chrono::steady_clock::now();
+    for (int r = 0; r < load_reps; ++r) {
+        ArimaModelHandle h;
+        if (!open_arima_model(model_path, h)) { std::filesystem::remove(bin_path); return 1; }
+        sink = sink + h.view.mu;
+    }
+    auto t1 = std::chrono::steady_clock::now();
+    for (int r = 0; r < load_reps; ++r) {
+        ArimaModelHandle h;
+        if (!open_arima_model(bin_path, h)) { std::filesystem::remove(bin_path); return 1; }
+        sink = sink + h.view.mu;
+    }
+    auto t2 = std::chrono::steady_clock::now();
+    std::filesystem::remove(bin_path);
+    std::cout << "load csv    : " << std::chrono::duration<double, std::micro>(t1 - t0).count() / load_reps << " us/model\n"
+              << "load bin    : " << std::chrono::duration<double, std::micro>(t2 - t1).count() / load_reps << " us/model" << std::endl;
+    return 0;
+}
+
+#ifdef ARIMA_ALLOC_CHECK
+// 建構後對多種 horizon 呼叫 forecast() / observe()，任何一次配置即失敗
+int run_alloc_check(const std::string& model_path, const std::string& input_path) {
+    ArimaModelHandle model;
+    if (!open_plain_model(model_path, model)) return 1;
+    auto history = load_history(input_path);
+    ArimaForecaster f;
+    if (!f.init(model.view, history.data(), history.size())) return 1;
+
+    const int horizons[] = {1, 25, 1000, 100000};
+    std::vector<double> out(100000);
+    std::vector<double> ref;
+    arima_forecast(load_arima_model(model_path), history, 1000, ref);
+
+    const size_t before = g_alloc_count.load();
+    for (int h : horizons) f.forecast(out.data(), h);
+    const bool same = std::equal(ref.begin(), ref.end(), out.begin());
+    f.observe(history.back());
+    f.forecast(out.data(), 25);
+    const size_t allocs = g_alloc_count.load() - before;
+
+    std::cout << "allocations after construction: " << allocs << '\n'
+              << "matches arima_forecast()      : " << (same ? "yes" : "no") << std::endl;
+    return (allocs == 0 && same) ? 0 : 1;
+}
+#endif
 
 //------------------------------------------------------------
-// ARIMA(p,d,q) rolling forecast ‒ 支援 d = 0/1/…、p 或 q = 0
+// 多執行緒滾動原點回測 ‒ 原點 t 以 y[0..t) 為歷史預測 n_steps 步，
+// 與 y[t..t+h) 比較；等同每個原點各跑一次 run_model，但全在記憶體內完成
 //------------------------------------------------------------
-void arima_forecast(
-    const std::unordered_map<std::string, double>& model,
-    const std::vector<double>& history,
-    int n_steps,
-    std::vector<double>& out_forecast
-) {
-    /* ---------- 0. 讀模型參數 ---------- */
-    const int p = int(model.at("order_p"));
-    const int d = int(model.at("order_d"));
-    const int q = int(model.at("order_q"));
-    const double mu = model.count("mu") ? model.at("mu") : 0.0;
-
-    if (p < 0 || d < 0 || q < 0) {                 // ★ 允許 p = 0，但不得為負
-        std::cerr << "Error: p/d/q must be ≥ 0\n";
-        return;
-    }
-
-    /* ---------- 1. 檢查並裁剪歷史 ---------- */
-    const int need = p + d;                        // 公式最少需要 p+d 筆 y
-    if (int(history.size()) < need) {              // ★ 修正括號 bug
-        std::cerr << "Error: history length < p + d = " << need << '\n';
-        return;
-    }
-    std::vector<double> hist(history.end() - need, history.end());
-
-    /* ---------- 2. 讀 φ / θ / ε ---------- */
-    std::vector<double> phi(p, 0.0), theta(q, 0.0), eps(q, 0.0);
-    for (int i = 0; i < p; ++i)
-        if (auto it = model.find("phi" + std::to_string(i + 1)); it != model.end())
-            phi[i] = it->second;
-
-    for (int j = 0; j < q; ++j) {
-        auto tkey = "theta" + std::to_string(j + 1);
-        auto ekey = "eps"   + std::to_string(j + 1);
-        if (auto it = model.find(tkey); it != model.end()) theta[j] = it->second;
-        if (auto it = model.find(ekey); it != model.end()) eps[j]   = it->second;
-    }
-
-    /* ---------- 3. 差分序列 ---------- */
-    std::vector<std::vector<double>> diff(d);      // diff[k] = Δ^{k+1}y
-    if (d > 0) {
-        diff[0].reserve(hist.size() - 1);
-        for (size_t i = 1; i < hist.size(); ++i)
-            diff[0].push_back(hist[i] - hist[i - 1]);
-
-        for (int k = 1; k < d; ++k) {
-            const auto& prev = diff[k - 1];
-            diff[k].reserve(prev.size() - 1);
-            for (size_t i = 1; i < prev.size(); ++i)
-                diff[k].push_back(prev[i] - prev[i - 1]);
-        }
-    }
-    /* ★ d==0 時 diff_d 指向 hist；d>0 指向 Δ^d y 序列 */
-    std::vector<double>& diff_d = (d == 0) ? hist : diff.back();
-
-    /* ---------- 4. 最新 y_t ---------- */
-    double last_level = hist.back();               // 原始尺度最新值
-
-    /* ---------- 5. Forecast loop ---------- */
-    for (int step = 0; step < n_steps; ++step) {
-
-        /* 5-1  AR 部分：φ ⋅ (y or Δ^d y) */
-        double ar_sum = 0.0;
-        for (int i = 0; i < p; ++i)
-            ar_sum += phi[i] * diff_d[diff_d.size() - 1 - i];
-
-        /* 5-2  MA 部分：θ ⋅ ε */
-        double ma_sum = 0.0;
-        for (int j = 0; j < q; ++j)
-            ma_sum += theta[j] * eps[j];
-
-        /* 5-3  差分層級預測值 */
-        double diff_d_hat = mu + ar_sum + ma_sum;
-
-        /* 5-4  把 diff_d_hat 推回原始尺度 ---------------------- */
-        double y_hat;
-        if (d == 0) {                              // ★ 無差分：直接相加
-            y_hat = last_level + diff_d_hat;
-        } else {
-            /* 逐層累加：new_diff[k] = diff[k].back() + carry */
-            double carry = diff_d_hat;             // 從 Δ^d ŷ 開始
-            for (int k = d - 1; k >= 1; --k) {     // k = d-1 … 1
-                double new_diff = diff[k - 1].back() + carry;
-                diff[k - 1].push_back(new_diff);   // 追加到對應差分序列
-                carry = new_diff;                  // 傳給下一層
-            }
-            y_hat = last_level + carry;            // 最後 carry = Δŷ
+struct BacktestResult {
+    std::vector<double> abs_sum, sq_sum;           // [h] 各 horizon 誤差累計
+    long origins = 0;
+};
+
+void backtest_range(const ArimaModelView& m, const std::vector<double>& y, int n_steps,
+                    long first, long last, BacktestResult& r) {
+    r.abs_sum.assign(n_steps, 0.0);
+    r.sq_sum.assign(n_steps, 0.0);
+    r.origins = 0;
+    if (first >= last) return;
+    ArimaForecaster f;
+    if (!f.init(m, y.data(), size_t(first))) return;
+    std::vector<double> fc(n_steps);
+    for (long t = first; t < last; ++t) {
+        f.reset(y.data(), size_t(t));
+        f.forecast(fc.data(), n_steps);
+        for (int h = 0; h < n_steps; ++h) {
+            const double e = fc[h] - y[t + h];
+            r.abs_sum[h] += std::abs(e);
+            r.sq_sum[h]  += e * e;
+        }
+        ++r.origins;
+    }
+}
+
+int run_backtest(const std::string& model_path, const std::string& input_path,
+                 const std::string& output_path, int n_steps, int n_threads) {
+    ArimaModelHandle model;
+    if (!open_plain_model(model_path, model)) return 1;
+    const auto y = load_history(input_path);
+    const long first = std::max(model.view.p + model.view.d, 1);
+    const long last  = long(y.size()) - n_steps + 1;   // 原點 t 需 y[t + n_steps - 1]
+    if (n_steps < 1 || last <= first) {
+        std::cerr << "Error: " << input_path << " is too short for n_steps=" << n_steps << '\n';
+        return 1;
+    }
+    if (n_threads <= 0) n_threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    n_threads = int(std::min<long>(n_threads, last - first));
+
+    /* 原點切成連續區段，每個執行緒各自累計，最後合併 */
+    auto t0 = std::chrono::steady_clock::now();
+    std::vector<BacktestResult> parts(n_threads);
+    std::vector<std::thread> pool;
+    const long total = last - first;
+    for (int k = 0; k < n_threads; ++k) {
+        const long a = first + total * k / n_threads;
+        const long b = first + total * (k + 1) / n_threads;
+        pool.emplace_back(backtest_range, std::cref(model.view), std::cref(y), n_steps, a, b, std::ref(parts[k]));
+    }
+    for (auto& th : pool) th.join();
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    BacktestResult all;
+    all.abs_sum.assign(n_steps, 0.0);
+    all.sq_sum.assign(n_steps, 0.0);
+    for (const auto& r : parts) {
+        all.origins += r.origins;
+        for (int h = 0; h < n_steps; ++h) { all.abs_sum[h] += r.abs_sum[h]; all.sq_sum[h] += r.sq_sum[h]; }
+    }
+    if (all.origins != total) { std::cerr << "Error: backtest worker failed\n"; return 1; }
+
+    std::ofstream file(output_path);
+    file << "horizon,mae,rmse\n";
+    for (int h = 0; h < n_steps; ++h)
+        file << h + 1 << "," << all.abs_sum[h] / all.origins << "," << std::sqrt(all.sq_sum[h] / all.origins) << "\n";
+    std::cout << "origins: " << all.origins << ", threads: " << n_threads << ", time: " << sec * 1e3 << " ms ("
+              << all.origins / sec << " forecasts/s)\n"
+              << "h=1 MAE " << all.abs_sum[0] / all.origins
+              << ", h=" << n_steps << " MAE " << all.abs_sum[n_steps - 1] / all.origins << std::endl;
+    return 0;
+}
+
+/* 精度檢查：在每個原點以 double 為基準，比較 float / Q16 / Q32 的預測，
+ * 記錄各 horizon 的最大絕對漂移與每次預測耗時；tolerance > 0 時
+ * 在漂移不超過 tolerance 的型別中挑最快的 */
+struct PrecisionResult {
+    std::string name;
+    std::vector<double> max_drift;   // [n_steps]
+    double sec = 0.0;
+};
+
+template <typename T>
+bool precision_run(const ArimaModelView& m, const std::vector<double>& y, int n_steps,
+                   long first, long last, const std::vector<double>& ref, PrecisionResult& r) {
+    BasicArimaForecaster<T> f;
+    if (!f.init(m, y.data(), size_t(first))) return false;
+    r.max_drift.assign(n_steps, 0.0);
+    std::vector<double> fc(n_steps);
+    double sec = 0.0;
+    for (long t = first; t < last; ++t) {
+        auto t0 = std::chrono::steady_clock::now();
+        f.reset(y.data(), size_t(t));
+        f.forecast(fc.data(), n_steps);
+        sec += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        const double* base = &ref[size_t(t - first) * n_steps];
+        for (int h = 0; h < n_steps; ++h)
+            r.max_drift[h] = std::max(r.max_drift[h], std::fabs(fc[h] - base[h]));
+    }
+    r.sec = sec;
+    return true;
+}
+
+// 以指定運算型別預測單序列 (precision = double / float / q16 / q32)
+bool arima_forecast_precision(const std::string& precision, const ArimaModelView& m,
+                              const std::vector<double>& history, int n_steps, std::vector<double>& out) {
+    out.assign(n_steps, 0.0);
+    auto run = [&](auto tag) {
+        BasicArimaForecaster<decltype(tag)> f;
+        if (!f.init(m, history)) return false;
+        f.forecast(out);
+        return true;
+    };
+    if (precision == "double") return arima_forecast_dispatch(m, history, out);
+    if (precision == "float")  return run(float{});
+    if (precision == "q16")    return run(FixedQ16{});
+    if (precision == "q32")    return run(FixedQ32{});
+    std::cerr << "Error: --precision must be double, float, q16 or q32\n";
+    return false;
+}
+
+int run_precision_check(const std::string& model_path, const std::string& input_path,
+                        const std::string& output_path, int n_steps, double tolerance) {
+    ArimaModelHandle model;
+    if (!open_plain_model(model_path, model)) return 1;
+    const auto y = load_history(input_path);
+    const long first = std::max(model.view.p + model.view.d, 1);
+    const long last  = long(y.size()) + 1;
+    if (n_steps < 1 || last <= first) {
+        std::cerr << "Error: " << input_path << " is too short for p + d\n";
+        return 1;
+    }
+
+    /* double 基準：所有原點的預測先存起來 */
+    std::vector<double> ref(size_t(last - first) * n_steps);
+    PrecisionResult base{"double", {}, 0.0};
+    {
+        ArimaForecaster f;
+        if (!f.init(model.view, y.data(), size_t(first))) return 1;
+        for (long t = first; t < last; ++t) {
+            auto t0 = std::chrono::steady_clock::now();
+            f.reset(y.data(), size_t(t));
+            f.forecast(&ref[size_t(t - first) * n_steps], n_steps);
+            base.sec += std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
         }
+    }
 
-        /* 5-5  更新狀態 / 序列 / 殘差 ------------------------ */
-        last_level = y_hat;
-        diff_d.push_back((d == 0) ? y_hat : diff_d_hat); // AR 需要
+    std::vector<PrecisionResult> res(3);
+    res[0].name = "float";
+    res[1].name = "q16.16";
+    res[2].name = "q32.32";
+    if (!precision_run<float>(model.view, y, n_steps, first, last, ref, res[0]) ||
+        !precision_run<FixedQ16>(model.view, y, n_steps, first, last, ref, res[1]) ||
+        !precision_run<FixedQ32>(model.view, y, n_steps, first, last, ref, res[2])) return 1;
 
-        if (q > 0) {                           // ε_{t+1} 期望 0 → 入首
-            eps.insert(eps.begin(),0.0);
-            eps.pop_back();
+    if (!output_path.empty()) {
+        std::ofstream file(output_path);
+        file << "horizon";
+        for (const auto& r : res) file << "," << r.name;
+        file << "\n";
+        for (int h = 0; h < n_steps; ++h) {
+            file << h + 1;
+            for (const auto& r : res) file << "," << r.max_drift[h];
+            file << "\n";
         }
+    }
 
-        out_forecast.push_back(y_hat);
+    const long origins = last - first;
+    std::cout << "origins: " << origins << ", max drift vs double over " << n_steps << " steps:\n";
+    std::cout << "  double : " << base.sec / origins * 1e9 << " ns/forecast\n";
+    const PrecisionResult* pick = &base;
+    for (const auto& r : res) {
+        const double worst = *std::max_element(r.max_drift.begin(), r.max_drift.end());
+        const bool ok = tolerance > 0 && worst <= tolerance;
+        std::cout << "  " << r.name << ": h=1 " << r.max_drift[0] << ", h=" << n_steps << " "
+                  << r.max_drift[n_steps - 1] << ", worst " << worst << ", "
+                  << r.sec / origins * 1e9 << " ns/forecast" << (ok ? "  (within tolerance)" : "") << "\n";
+        if (ok && r.sec < pick->sec) pick = &r;
     }
+    if (tolerance > 0)
+        std::cout << "cheapest within tolerance " << tolerance << ": " << pick->name
+                  << " (use --precision=" << pick->name.substr(0, pick->name.find('.')) << ")\n";
+    std::cout << std::flush;
+    return 0;
 }
 
+// 讀取多欄歷史資料：每欄一條序列；第一行若非數字視為欄名
+bool load_history_columns(const std::string& filename,
+                          std::vector<std::string>& names,
+                          std::vector<std::vector<double>>& cols) {
+    if (!csv_read_columns(filename, names, cols)) {
+        std::cerr << "Cannot open input: " << filename << '\n';
+        return false;
+    }
+    if (names.size() != cols.size()) {
+        names.clear();
+        for (size_t c = 0; c < cols.size(); ++c) names.push_back("s" + std::to_string(c));
+    }
+    return !cols.empty();
+}
+
+/* CSV 讀取吞吐量：舊的 getline + stod (try/catch) 與 csv_reader.h 的 mmap + from_chars
+ * 各讀一次同一檔案，兩者結果須相同。synthetic_lines > 0 時先產生該行數的合成檔
+ * (寫到 path，每 1000 行插入一行無效內容以計入例外成本) */
+int run_csv_bench(const std::string& path, long synthetic_lines) {
+    if (synthetic_lines > 0) {
+        std::ofstream f(path);
+        if (!f.is_open()) { std::cerr << "Cannot write: " << path << '\n'; return 1; }
+        f << "value\n";
+        char line[32];
+        uint64_t x = 88172645463325252ull;
+        for (long i = 0; i < synthetic_lines; ++i) {
+            x ^= x << 13; x ^= x >> 7; x ^= x << 17;          // xorshift
+            if (i % 1000 == 999) { f << "n/a\n"; continue; }
+            int len = std::snprintf(line, sizeof(line), "%.4f\n", 2.0 + double(x % 4330000) / 1e5);
+            f.write(line, len);
+        }
+        std::cout << "wrote " << synthetic_lines << " lines to " << path << std::endl;
+    }
+
+    auto timed = [](auto fn) {
+        auto t0 = std::chrono::steady_clock::now();
+        fn();
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+    };
+    std::vector<double> a, b;
+    const double t_old = timed([&] {
+        std::ifstream file(path);
+        std::string line;
+        while (std::getline(file, line)) {
+            if (line.empty()) continue;
+            try { a.push_back(std::stod(line)); } catch (...) {}
+        }
+    });
+    CsvStats st;
+    const double t_new = timed([&] { csv_read_column(path, b, CsvOptions{}, &st); });
+    const double mb = double(std::filesystem::file_size(path)) / 1e6;
+
+    std::cout << path << ": " << st.lines << " lines, " << mb << " MB, " << st.values << " values, "
+              << st.header << " header, " << st.invalid << " invalid, " << st.blank << " blank\n"
+              << "  getline+stod : " << t_old * 1e3 << " ms (" << mb / t_old << " MB/s)\n"
+              << "  mmap+from_chars: " << t_new * 1e3 << " ms (" << mb / t_new << " MB/s), "
+              << t_old / t_new << "x\n"
+              << "  results " << (a == b ? "identical" : "DIFFER") << std::endl;
+    return a == b ? 0 : 1;
+}
+
+// 讀取外生變數 CSV (每欄一個變數，第一行可為欄名)，打包成欄優先緩衝
+bool load_exog(const std::string& filename, ExogMatrix& X) {
+    std::vector<std::string> names;
+    std::vector<std::vector<double>> cols;
+    if (!load_history_columns(filename, names, cols)) {
+        std::cerr << "Error: no exogenous data in " << filename << '\n';
+        return false;
+    }
+    X.k = int(cols.size());
+    X.rows = cols[0].size();
+    X.data.resize(size_t(X.k) * X.rows);
+    for (int j = 0; j < X.k; ++j) std::copy(cols[j].begin(), cols[j].end(), X.data.begin() + size_t(j) * X.rows);
+    return true;
+}
+
+// 讀取目錄下所有 *.csv (依檔名排序)，每個檔案一條序列
+bool load_history_dir(const std::string& dir,
+                      std::vector<std::string>& names,
+                      std::vector<std::vector<double>>& cols) {
+    std::vector<std::filesystem::path> files;
+    for (const auto& e : std::filesystem::directory_iterator(dir))
+        if (e.is_regular_file() && e.path().extension() == ".csv") files.push_back(e.path());
+    std::sort(files.begin(), files.end());
+    for (const auto& f : files) {
+        names.push_back(f.stem().string());
+        cols.push_back(load_history(f.string()));
+    }
+    return !cols.empty();
+}
+
+// 批次輸出：第一行為序列名稱，其後每行一個預測步
+void write_forecast_batch(const std::string& filename,
+                          const std::vector<std::string>& names,
+                          const std::vector<double>& out) {
+    std::ofstream file(filename);
+    const size_t n = names.size();
+    for (size_t s = 0; s < n; ++s) file << names[s] << (s + 1 < n ? "," : "\n");
+    for (size_t i = 0; i < out.size(); ++i) file << out[i] << ((i + 1) % n ? "," : "\n");
+}
+
+// --model 為目錄時依序列名稱找 <dir>/<name>.bin 或 <name>.csv，否則全部共用
+bool load_batch_models(const std::string& model_path, const std::vector<std::string>& names,
+                       std::vector<ArimaModelHandle>& handles,
+                       std::vector<ArimaModelView>& views) {
+    if (std::filesystem::is_directory(model_path)) {
+        handles.resize(names.size());
+        for (size_t s = 0; s < names.size(); ++s) {
+            auto path = std::filesystem::path(model_path) / (names[s] + ".bin");
+            if (!std::filesystem::exists(path)) path.replace_extension(".csv");
+            if (!std::filesystem::exists(path)) { std::cerr << "Error: missing model " << path << '\n'; return false; }
+            if (!open_plain_model(path.string(), handles[s])) return false;
+        }
+    } else {
+        handles.resize(1);
+        if (!open_plain_model(model_path, handles[0])) return false;
+    }
+    views.clear();
+    for (const auto& h : handles) views.push_back(h.view);
+    return true;
+}
+
+
+// 讀入多序列歷史與模型 (--batch / --stream 共用)；views 指向 handles，兩者同生命週期
+bool load_batch_inputs(const std::string& model_path, const std::string& input_path,
+                       std::vector<std::string>& names,
+                       std::vector<std::vector<double>>& histories,
+                       std::vector<ArimaModelHandle>& handles,
+                       std::vector<ArimaModelView>& views) {
+    bool ok = std::filesystem::is_directory(input_path)
+            ? load_history_dir(input_path, names, histories)
+            : load_history_columns(input_path, names, histories);
+    if (!ok) { std::cerr << "Error: no series found in " << input_path << '\n'; return false; }
+    return load_batch_models(model_path, names, handles, views);
+}
+
+// simd: "" = 純量批次，"double" / "float" = SIMD lane 核心；lanes = 每 block 序列數
+// bench = true 時另跑一次純量批次，比較耗時與最大差異
+int run_batch(const std::string& model_path, const std::string& input_path,
+              const std::string& output_path, int n_steps,
+              const std::string& simd = "", int lanes = 8, bool bench = false) {
+    std::vector<std::string> names;
+    std::vector<std::vector<double>> histories;
+    std::vector<ArimaModelHandle> handles;
+    std::vector<ArimaModelView> params;
+    if (!load_batch_inputs(model_path, input_path, names, histories, handles, params)) return 1;
+    if (!simd.empty() && simd != "double" && simd != "float") {
+        std::cerr << "Error: --simd must be double or float\n";
+        return 1;
+    }
+    if (lanes != 4 && lanes != 8 && lanes != 16) {
+        std::cerr << "Error: --lanes must be 4, 8 or 16\n";
+        return 1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    ArimaBatch batch;
+    if (!init_arima_batch(params, series_spans(histories), names, batch)) return 1;
+    ArimaBatch scalar_batch;
+    if (bench && !simd.empty()) scalar_batch = batch;      // 純量比較用的初始狀態
+    std::vector<double> out(size_t(std::max(n_steps, 0)) * batch.n);
+    SimdIsa isa = SimdIsa::Scalar;
+    int block = lanes;
+    auto t_fc = std::chrono::steady_clock::now();
+    bool used_lanes = !simd.empty() && arima_forecast_lanes(batch, lanes, simd == "float", n_steps, out, isa, block);
+    if (!simd.empty() && !used_lanes)
+        std::cerr << "Warning: --simd needs the same d for every series, using the scalar batch path\n";
+    if (!used_lanes) arima_forecast_batch(batch, n_steps, out);
+    double fc_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t_fc).count();
+    double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    write_forecast_batch(output_path, names, out);
+    std::cout << "series: " << names.size() << ", forecast time: " << sec * 1e3 << " ms"
+              << " (" << (sec > 0 ? names.size() / sec : 0.0) << " series/s)" << std::endl;
+    if (used_lanes)
+        std::cout << "simd: " << simd_isa_name(isa) << ", " << simd << ", " << block << " series/block"
+                  << (block != lanes ? " (--lanes=" + std::to_string(lanes) + " raised to the register width)" : std::string())
+                  << std::endl;
+
+    if (bench && used_lanes) {
+        std::vector<double> ref;
+        auto t1 = std::chrono::steady_clock::now();
+        arima_forecast_batch(scalar_batch, n_steps, ref);
+        double ref_sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t1).count();
+        double max_diff = 0.0;
+        for (size_t k = 0; k < ref.size(); ++k) max_diff = std::max(max_diff, std::fabs(out[k] - ref[k]));
+        std::cout << "simd forecast: " << fc_sec * 1e3 << " ms, scalar batch: " << ref_sec * 1e3
+                  << " ms, max |simd - scalar| = " << max_diff
+                  << (out == ref ? " (bit-identical)" : "") << std::endl;
+    }
+    return 0;
+}
+
+/* 常駐 walk-forward 模式：--input 只在啟動時讀一次作為暖機狀態，
+ * 之後從 obs_path (預設 "-" = stdin，也可為 FIFO) 每行讀一筆新觀測
+ * (多序列時以逗號分隔，順序同 --input 欄位)，更新狀態後輸出下一段 n_steps 預測。
+ * 每行輸出 n_steps × n 個值，排列同 --batch 的逐步逐序列。                  */
+int run_stream(const std::string& model_path, const std::string& input_path,
+               const std::string& obs_path, const std::string& output_path, int n_steps) {
+    std::vector<std::string> names;
+    std::vector<std::vector<double>> histories;
+    std::vector<ArimaModelHandle> handles;
+    std::vector<ArimaModelView> params;
+    if (!load_batch_inputs(model_path, input_path, names, histories, handles, params)) return 1;
+
+    ArimaBatch state, scratch;
+    if (!init_arima_batch(params, series_spans(histories), names, state)) return 1;
+    const size_t n = names.size();
+
+    std::ifstream obs_file;
+    if (obs_path != "-") {
+        obs_file.open(obs_path);
+        if (!obs_file.is_open()) { std::cerr << "Cannot open observations: " << obs_path << '\n'; return 1; }
+    }
+    std::istream& obs = obs_path == "-" ? std::cin : obs_file;
+
+    std::ofstream out_file;
+    if (output_path != "-") {
+        out_file.open(output_path);
+        if (!out_file.is_open()) { std::cerr << "Cannot write output: " << output_path << '\n'; return 1; }
+    }
+    std::ostream& out = output_path == "-" ? std::cout : out_file;
+
+    /* 所有緩衝在迴圈前配置；每個 tick 只就地解析、observe、複製狀態並預測，不配置記憶體 */
+    std::vector<double> y(n), dhat(n), ar(n), ma(n), carry(n), fc(size_t(std::max(n_steps, 0)) * n);
+    scratch = state;
+    std::string line;
+    long ticks = 0;
+    while (std::getline(obs, line)) {
+        if (line.empty()) continue;
+        const char* p = line.data();
+        const char* end = p + line.size();
+        size_t c = 0;
+        while (c < n && (p = csv_parse_number(p, end, y[c]))) {
+            ++c;
+            while (p < end && (*p == ' ' || *p == '\t' || *p == '\r')) ++p;
+            if (p < end && *p == ',') ++p;
+            else break;
+        }
+        if (c != n) { std::cerr << "Skip bad observation: " << line << '\n'; continue; }
+
+        arima_batch_observe(state, y.data(), dhat.data(), ar.data(), ma.data());
+        scratch = state;                           // 同尺寸 → 不重新配置
+        arima_forecast_batch(scratch, n_steps, fc.data(), ar.data(), ma.data(), carry.data());
+        for (size_t i = 0; i < fc.size(); ++i) out << fc[i] << (i + 1 < fc.size() ? "," : "\n");
+        out.flush();
+        ++ticks;
+    }
+    std::cerr << "stream closed after " << ticks << " observations\n";
+    return 0;
+}
+
+/* --refit：order 取自 --order 或既有 --model。
+ * 有 --acov-state 且檔案存在時，--input 只放上次之後新增的觀測，累積狀態就地更新；
+ * 否則 --input 為完整歷史 (若指定 --acov-state 則建立新狀態)。 */
+int run_refit(const std::string& model_path, const std::string& input_path, const std::string& output_path,
+              std::vector<int> order, const std::string& state_path, int tail_len) {
+    if (order.empty() && !model_path.empty()) {
+        ArimaModelHandle h;
+        if (!open_plain_model(model_path, h)) return 1;
+        order = {h.view.p, h.view.d, h.view.q};
+    }
+    if (order.size() != 3 || order[0] < 0 || order[1] < 0 || order[2] < 0) {
+        std::cerr << "Error: --refit needs --order=p,d,q or an existing --model\n";
+        return 1;
+    }
+    const int p = order[0], d = order[1], q = order[2];
+    if (d == 0) {
+        std::cerr << "Error: --refit needs d ≥ 1; with d = 0 the forecaster adds the ARMA value to the last "
+                     "observation, so a fitted ARMA model cannot replace model.csv\n";
+        return 1;
+    }
+
+    if (tail_len < 0 || tail_len > AcovAccumulator::kMaxTail) {
+        std::cerr << "Error: --acov-tail must be 1.." << AcovAccumulator::kMaxTail << '\n';
+        return 1;
+    }
+
+    auto t0 = std::chrono::steady_clock::now();
+    AcovAccumulator acc;
+    const int lags = hr_long_order(p, q) + std::max(p, q);
+    if (lags > AcovAccumulator::kMaxLag) { std::cerr << "Error: order too large for --refit\n"; return 1; }
+    const bool resumed = !state_path.empty() && std::filesystem::exists(state_path);
+    if (resumed && !acc.load(state_path, d, lags, tail_len)) return 1;     // 壞檔不默默重建、覆寫
+    if (!resumed) acc.reset(d, lags, tail_len > 0 ? tail_len : AcovAccumulator::kDefaultTail);
+
+    const auto values = load_history(input_path);
+    for (double y : values) acc.push(y);
+
+    ArimaParams fit;
+    if (!arima_refit(acc, p, q, fit)) return 1;
+    if (!write_arima_csv(output_path, fit)) return 1;
+    if (!state_path.empty() && !acc.save(state_path)) return 1;
+    double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    std::cout << "refit p" << p << "d" << d << "q" << q << (resumed ? " (incremental)" : "")
+              << ": +" << values.size() << " points, " << acc.n_raw << " total, "
+              << ms << " ms, sigma2=" << fit.sigma2 << std::endl;
+    return 0;
+}
+
+/* 以預測器重播寫出的模型：自 y[p+d] 起逐點 forecast 一步再 observe，
+ * 其殘差應與計分用的 CSS 殘差相同，最後的 MA 狀態應等於寫出的 eps。回傳最大差距 */
+bool verify_order_fit(const std::string& model_path, const std::vector<double>& y, const OrderLevel& lv,
+                      long start, double& max_diff) {
+    ArimaModelHandle h;
+    if (!open_plain_model(model_path, h)) return false;
+    const ArimaModelView& m = h.view;
+    std::vector<double> e;
+    ArimaParams fit;
+    fit.p = m.p; fit.d = m.d; fit.q = m.q; fit.mu = m.mu;
+    fit.phi.assign(m.phi, m.phi + m.p);
+    fit.theta.assign(m.theta, m.theta + m.q);
+    css_residuals(lv.x, fit, e);
+
+    const std::vector<double> zeros(m.q, 0.0);       // 計分遞迴的起點殘差為 0
+    ArimaModelView v0 = m;
+    v0.eps = zeros.data();
+    ArimaForecaster f;
+    if (!f.init(v0, y.data(), size_t(m.p + m.d))) return false;
+    max_diff = 0.0;
+    for (size_t t = size_t(m.p + m.d); t < y.size(); ++t) {
+        double fc;
+        f.forecast(&fc, 1);
+        if (long(t) >= start) max_diff = std::max(max_diff, std::abs((y[t] - fc) - e[t - m.d]));
+        f.observe(y[t]);
+    }
+    for (int j = 0; j < m.q; ++j) max_diff = std::max(max_diff, std::abs(f.resids()[j] - m.eps[j]));
+    return true;
+}
+
+/* --order-search：max_order = {P, D, Q}，criterion = "aic" / "bic"；
+ * 勝出的模型寫成 model.csv，並列出分數最好的幾個候選 */
+int run_order_search(const std::string& input_path, const std::string& output_path,
+                     std::vector<int> max_order, const std::string& criterion, int n_threads) {
+    if (max_order.empty()) max_order = {5, 2, 5};
+    if (max_order.size() != 3 || max_order[0] < 0 || max_order[1] < 1 || max_order[2] < 0) {
+        std::cerr << "Error: --max-order must be P,D,Q with D ≥ 1 (d = 0 is not searched)\n";
+        return 1;
+    }
+    if (criterion != "aic" && criterion != "bic") { std::cerr << "Error: --criterion must be aic or bic\n"; return 1; }
+    const int P = max_order[0], D = max_order[1], Q = max_order[2];
+    const long start = D + P;
+
+    auto t0 = std::chrono::steady_clock::now();
+    const auto y = load_history(input_path);
+    if (n_threads <= 0) n_threads = int(std::max(1u, std::thread::hardware_concurrency()));
+    std::vector<OrderLevel> levels;
+    std::vector<OrderCandidate> cands;
+    if (!arima_order_search(y, P, D, Q, n_threads, levels, cands)) return 1;
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+
+    const bool use_bic = (criterion == "bic");
+    auto score = [&](const OrderCandidate& c) { return use_bic ? c.bic : c.aic; };
+    std::vector<const OrderCandidate*> ranked;
+    for (const auto& c : cands) if (c.ok) ranked.push_back(&c);
+    if (ranked.empty()) { std::cerr << "Error: no candidate order could be fitted\n"; return 1; }
+    std::stable_sort(ranked.begin(), ranked.end(),
+                     [&](const OrderCandidate* a, const OrderCandidate* b) { return score(*a) < score(*b); });
+
+    const OrderCandidate& best = *ranked.front();
+    if (!write_arima_csv(output_path, best.fit)) return 1;
+    double max_diff = 0.0;
+    if (!verify_order_fit(output_path, y, levels[best.d], start, max_diff)) return 1;
+    double scale = 1.0;
+    for (double v : y) scale = std::max(scale, std::abs(v));
+    if (!(max_diff <= 1e-9 * scale)) {
+        std::cerr << "Error: forecasting " << output_path << " does not reproduce the scored residuals (max |diff| = "
+                  << max_diff << ")\n";
+        return 1;
+    }
+
+    std::cout << "candidates: " << ranked.size() << "/" << cands.size() << ", threads: " << n_threads
+              << ", scored on " << y.size() - start << " points, time: " << ms << " ms\n"
+              << "rank,order,aic,bic,sigma2\n";
+    for (size_t r = 0; r < std::min<size_t>(ranked.size(), 10); ++r) {
+        const auto& c = *ranked[r];
+        std::cout << r + 1 << ",p" << c.p << "d" << c.d << "q" << c.q << "," << c.aic << "," << c.bic << "," << c.sigma2 << "\n";
+    }
+    std::cout << "best by " << criterion << ": p" << best.p << "d" << best.d << "q" << best.q
+              << " -> " << output_path << " (replayed residuals max |diff| = " << max_diff << ")" << std::endl;
+    return 0;
+}
+
+/* 群組定義 CSV：每行 "群組,成員,成員,..."，成員為底層序列名稱或前面已定義的群組；
+ * 空行與 # 開頭的行略過。filename 為空時只有一個加總全部序列的 "total" */
+bool load_hierarchy(const std::string& filename, const std::vector<std::string>& bottom, Hierarchy& H) {
+    H = Hierarchy{};
+    H.n = int(bottom.size());
+    if (filename.empty()) {
+        std::vector<int> all(H.n);
+        for (int s = 0; s < H.n; ++s) all[s] = s;
+        return hierarchy_add_group(H, "total", all);
+    }
+    std::ifstream file(filename);
+    if (!file.is_open()) { std::cerr << "Cannot open hierarchy: " << filename << '\n'; return false; }
+    std::unordered_map<std::string, int> index;
+    for (int s = 0; s < H.n; ++s) index[bottom[s]] = s;
+    auto trim = [](std::string f) {
+        f.erase(0, f.find_first_not_of(" \t\r"));
+        f.erase(f.find_last_not_of(" \t\r") + 1);
+        return f;
+    };
+    std::string line;
+    while (std::getline(file, line)) {
+        line = trim(line);
+        if (line.empty() || line[0] == '#') continue;
+        std::stringstream ss(line);
+        std::vector<std::string> fields;
+        for (std::string f; std::getline(ss, f, ',');) fields.push_back(trim(f));
+        if (fields.size() < 2) { std::cerr << "Error: group without members: " << line << '\n'; return false; }
+        if (index.count(fields[0])) { std::cerr << "Error: duplicate node name " << fields[0] << '\n'; return false; }
+        std::vector<int> mem;
+        for (size_t j = 1; j < fields.size(); ++j) {
+            auto it = index.find(fields[j]);
+            if (it == index.end()) { std::cerr << "Error: unknown member " << fields[j] << " in group " << fields[0] << '\n'; return false; }
+            mem.push_back(it->second);
+        }
+        index[fields[0]] = H.n + int(H.names.size());
+        if (!hierarchy_add_group(H, fields[0], mem)) return false;
+    }
+    if (H.names.empty()) { std::cerr << "Error: no groups in " << filename << '\n'; return false; }
+    return true;
+}
+
+/* --hierarchy：底層 = --batch 的輸入，群組定義見 load_hierarchy()。
+ * method = "bu" 只預測底層再加總；"ols" / "mint" 另以群組的加總歷史預測群組
+ * (--model 為目錄時需有 <群組>.csv)，再調和成一致的預測。輸出欄位為底層後接群組 */
+int run_hierarchy(const std::string& model_path, const std::string& input_path, const std::string& hierarchy_path,
+                  const std::string& output_path, int n_steps, const std::string& method) {
+    if (method != "bu" && method != "ols" && method != "mint") {
+        std::cerr << "Error: --reconcile must be bu, ols or mint\n";
+        return 1;
+    }
+    std::vector<std::string> names;
+    std::vector<std::vector<double>> histories;
+    bool ok = std::filesystem::is_directory(input_path)
+            ? load_history_dir(input_path, names, histories)
+            : load_history_columns(input_path, names, histories);
+    if (!ok) { std::cerr << "Error: no series found in " << input_path << '\n'; return 1; }
+    Hierarchy H;
+    if (!load_hierarchy(hierarchy_path, names, H)) return 1;
+    const int n = H.n, k = int(H.names.size()), m = n + k;
+
+    auto t0 = std::chrono::steady_clock::now();
+    /* 各序列對齊最新的 len 筆，群組歷史再由成員逐點加總 */
+    size_t len = histories[0].size();
+    for (const auto& h : histories) len = std::min(len, h.size());
+    for (auto& h : histories) h.erase(h.begin(), h.end() - len);
+    std::vector<std::string> node_names = names;
+    node_names.insert(node_names.end(), H.names.begin(), H.names.end());
+    if (method != "bu") hierarchy_group_histories(H, histories);
+
+    /* 基礎預測：bu 只跑底層，ols / mint 全部節點同一批 */
+    const std::vector<std::string>& batch_names = method == "bu" ? names : node_names;
+    std::vector<ArimaModelHandle> handles;
+    std::vector<ArimaModelView> views;
+    if (!load_batch_models(model_path, batch_names, handles, views)) return 1;
+    ArimaBatch batch;
+    const std::vector<Span<const double>> series = series_spans(histories);
+    if (!init_arima_batch(views, series, batch_names, batch)) return 1;
+    std::vector<double> base;
+    arima_forecast_batch(batch, n_steps, base);
+
+    std::vector<double> fc(size_t(n_steps) * m);
+    for (int step = 0; step < n_steps; ++step)
+        std::copy_n(&base[size_t(step) * batch.n], batch.n, &fc[size_t(step) * m]);
+    double base_gap = 0.0, lambda = -1.0;
+    if (method == "bu") {
+        for (int step = 0; step < n_steps; ++step) hierarchy_sums(H, &fc[size_t(step) * m]);
+    } else {
+        base_gap = hierarchy_max_gap(H, fc);
+        MintWeights W;
+        if (method == "mint") {
+            std::vector<double> X;
+            int T = 0;
+            if (!batch_residuals(views, series, node_names, X, T) || !W.init(std::move(X), m, T)) return 1;
+            lambda = W.lambda;
+        }
+        if (!hierarchy_reconcile(H, method == "mint" ? &W : nullptr, fc)) return 1;
+    }
+    const double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+
+    write_forecast_batch(output_path, node_names, fc);
+    std::cout << "series: " << n << ", groups: " << k << ", reconcile: " << method
+              << ", time: " << sec * 1e3 << " ms" << std::endl;
+    if (method != "bu")
+        std::cout << "max |group - sum of members|: base " << base_gap << ", reconciled "
+                  << hierarchy_max_gap(H, fc) << std::endl;
+    if (lambda >= 0.0) std::cout << "mint shrinkage lambda: " << lambda << std::endl;
+    return 0;
+}
 
 // 寫出預測結果
 void write_forecast(const std::string& filename, const std::vector<double>& forecast) {
@@ -151,9 +937,204 @@ void write_forecast(const std::string& filename, const std::vector<double>& fore
     for (const auto& y : forecast) file << y << "\n";
 }
 
+// 寫出預測與區間：forecast,lower80,upper80,lower95,upper95,...
+void write_forecast_intervals(const std::string& filename, const std::vector<double>& forecast,
+                              const ArimaIntervals& iv, const std::vector<double>& bands) {
+    std::ofstream file(filename);
+    const size_t h = forecast.size();
+    file << "forecast";
+    for (int l : iv.levels) file << ",lower" << l << ",upper" << l;
+    file << "\n";
+    for (size_t j = 0; j < h; ++j) {
+        file << forecast[j];
+        for (size_t l = 0; l < iv.levels.size(); ++l)
+            file << "," << bands[(2 * l) * h + j] << "," << bands[(2 * l + 1) * h + j];
+        file << "\n";
+    }
+}
+
+/* 季節 (SarimaForecaster) 及 / 或外生變數模型的單序列預測。
+ * ARIMAX 為「迴歸 + ARIMA 誤差」：u_t = y_t - x_t·β 以 (S)ARIMA 預測，
+ * 再加上未來的 x·β (exog_future_path，至少 n_steps 行)。exog_path 與 --input 逐行對齊 */
+int run_sarimax(const ArimaParams& params, const std::string& input_path,
+                const std::string& exog_path, const std::string& exog_future_path,
+                const std::string& output_path, int n_steps) {
+    auto history = load_history(input_path);
+    std::vector<double> future_reg(n_steps, 0.0);
+    if (params.k > 0) {
+        if (exog_path.empty() || exog_future_path.empty()) {
+            std::cerr << "Error: model has order_x=" << params.k << ", needs --exog and --exog-future\n";
+            return 1;
+        }
+        ExogMatrix X, X_future;
+        if (!load_exog(exog_path, X) || !load_exog(exog_future_path, X_future)) return 1;
+        if (X.k != params.k || X_future.k != params.k) {
+            std::cerr << "Error: exogenous files need " << params.k << " columns\n";
+            return 1;
+        }
+        if (X.rows != history.size() || X_future.rows < size_t(n_steps)) {
+            std::cerr << "Error: --exog needs one row per input point and --exog-future at least n_steps rows\n";
+            return 1;
+        }
+        auto t0 = std::chrono::steady_clock::now();
+        std::vector<double> reg(history.size());
+        exog_regression(X, params.beta, reg);
+        for (size_t t = 0; t < history.size(); ++t) history[t] -= reg[t];
+        exog_regression(X_future, params.beta, future_reg);
+        double sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+        std::cout << "exogenous: " << params.k << " regressors, " << history.size() + n_steps
+                  << " rows in " << sec * 1e3 << " ms" << std::endl;
+    }
+
+    std::vector<double> forecast(n_steps);
+    if (params.seasonal()) {
+        SarimaForecaster f;
+        if (!f.init(params, history, n_steps)) return 1;
+        f.forecast(forecast.data(), n_steps);
+        std::cout << "seasonal s=" << params.s << ": " << f.nonzero_lags() << " nonzero lags, "
+                  << f.stored_values() << " values kept" << std::endl;
+    } else if (!arima_forecast_dispatch(view_of(params), history, forecast)) {
+        return 1;
+    }
+    for (int h = 0; h < n_steps; ++h) forecast[h] += future_reg[h];
+    write_forecast(output_path, forecast);
+    return 0;
+}
+
+/* 暖啟動：有 state_in 時從快照恢復，input 只含快照之後的新觀測 (逐筆 observe)，
+ * 成本與新資料量成正比；否則照常由 input 最後 p+d 筆建立狀態。
+ * state_out 非空時把觀測完的狀態寫回 (可與 state_in 為同一檔) */
+bool forecast_with_state(const ArimaModelView& m, const std::string& input_path,
+                         const std::string& state_in, const std::string& state_out,
+                         int n_steps, std::vector<double>& forecast) {
+    ArimaForecaster f;
+    size_t n_new = 0;
+    if (!state_in.empty()) {
+        if (!f.load_state(m, state_in)) return false;
+        const auto obs = load_history(input_path);
+        for (double y : obs) f.observe(y);
+        n_new = obs.size();
+    } else {
+        const auto history = load_history_tail(input_path, size_t(std::max(m.p + m.d, 1)));
+        if (!f.init(m, history.data(), history.size())) return false;
+    }
+    if (!state_out.empty() && !f.save_state(state_out)) return false;
+    forecast.assign(n_steps, 0.0);
+    f.forecast(forecast.data(), n_steps);
+    if (!state_in.empty()) std::cout << "resumed from " << state_in << " + " << n_new << " new points" << std::endl;
+    return true;
+}
+
+/* --kalman：input 每行 "時間戳,值" (第一行可為表頭)，時間格 = round((t - t0) / period)，
+ * period 未指定時取相鄰時間戳正差的中位數。值為空、nan 或無法解析即為缺值；
+ * 時間戳跳過的格子只做預測步，不需內插或重新整理檔案。重複或倒退的時間戳略過。
+ * 起始狀態取最先出現的 max(p+d,1) 個連續有效值，之後每行成本固定 */
+int run_kalman(const std::string& model_path, const std::string& input_path,
+               const std::string& output_path, int n_steps, double period) {
+    ArimaModelHandle model;
+    if (!open_plain_model(model_path, model)) return 1;
+    CsvFile file;
+    if (!file.open(input_path)) { std::cerr << "Cannot open input: " << input_path << '\n'; return 1; }
+
+    auto t_start = std::chrono::steady_clock::now();
+    if (period <= 0.0) {                           // 相鄰正時間差的中位數 (不受缺值與抖動影響)
+        std::vector<double> gaps;
+        double prev = std::numeric_limits<double>::quiet_NaN();
+        csv_for_each_line(file.begin(), file.end(), [&](const char* line, const char* le) {
+            const char *b, *e;
+            double t;
+            if (!csv_field(line, le, ',', 0, b, e) || !parse_timestamp(b, e, t)) return;
+            if (t > prev) gaps.push_back(t - prev);
+            prev = t;
+        });
+        if (gaps.empty()) { std::cerr << "Error: cannot infer the sampling period, pass --period\n"; return 1; }
+        std::nth_element(gaps.begin(), gaps.begin() + gaps.size() / 2, gaps.end());
+        period = gaps[gaps.size() / 2];
+    }
+
+    const size_t warm = size_t(std::max(model.view.p + model.view.d, 1));
+    KalmanArima kf;
+    bool ready = false, have_t0 = false;
+    double t0 = 0.0;
+    long cur = -1;                                  // 已處理到的時間格
+    std::vector<double> head;                       // 暖機用的連續有效值
+    size_t lines = 0, observed = 0, missing = 0, skipped = 0;
+    bool failed = false;
+    csv_for_each_line(file.begin(), file.end(), [&](const char* line, const char* le) {
+        if (failed || line == le) return;
+        ++lines;
+        const char *b, *e;
+        double t, v = 0.0;
+        if (!csv_field(line, le, ',', 0, b, e) || !parse_timestamp(b, e, t)) {
+            if (lines > 1 || have_t0) ++skipped;    // 第一行為表頭
+            return;
+        }
+        if (!have_t0) { t0 = t; have_t0 = true; }
+        const long k = std::lround((t - t0) / period);
+        if (k <= cur) { ++skipped; return; }
+        const bool has = csv_field(line, le, ',', 1, b, e) && csv_parse_number(b, e, v) && std::isfinite(v);
+        if (!ready) {
+            if (!has || k != cur + 1) head.clear();
+            if (has) head.push_back(v);
+            observed += has;
+            missing += size_t(k - cur - 1) + !has;
+            cur = k;
+            if (head.size() == warm) {
+                if (!kf.init(model.view, head.data(), head.size())) failed = true;
+                ready = true;
+            }
+            return;
+        }
+        for (long s = cur; s < k; ++s) kf.predict();
+        missing += size_t(k - cur - 1);
+        if (has) { kf.update(v); ++observed; } else ++missing;
+        cur = k;
+    });
+    if (failed) return 1;
+    if (!ready) {
+        std::cerr << "Error: " << input_path << " has no " << warm << " consecutive values to start the filter\n";
+        return 1;
+    }
+    std::vector<double> forecast(n_steps);
+    kf.forecast(forecast.data(), n_steps);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_start).count();
+
+    write_forecast(output_path, forecast);
+    std::cout << "kalman: " << observed << " observations, " << missing << " missing slots, "
+              << skipped << " lines skipped, period " << period << " s, " << ms << " ms ("
+              << (cur > 0 ? ms * 1e3 / double(cur + 1) : 0.0) << " us/slot)\n"
+              << "filtered level: " << kf.level() << " (sd " << std::sqrt(std::max(kf.level_var(), 0.0)) << ")" << std::endl;
+    return 0;
+}
+
 int main(int argc, char* argv[]) {
     std::string model_path, input_path, output_path;
     int n_steps = 25;
+    bool batch = false, stream = false, bench = false, convert = false, alloc_check = false;
+    std::string obs_path = "-";
+    std::vector<long> horizons;
+    std::vector<int> interval_levels;
+    bool refit = false, backtest = false;
+    int n_threads = 0;
+    std::string simd;
+    int lanes = 8;
+    bool precision_check = false;
+    std::string precision = "double";
+    double tolerance = 0.0;
+    std::string exog_path, exog_future_path;
+    std::string state_in, state_out;
+    bool csv_bench = false;
+    long synthetic_lines = 0;
+    std::vector<int> order;
+    std::string acov_state_path;
+    int acov_tail = 0;                             // 0 = 新狀態用 AcovAccumulator::kDefaultTail，續算沿用存檔
+    bool order_search = false;
+    std::vector<int> max_order;
+    std::string criterion = "aic";
+    bool hierarchy = false;
+    std::string hierarchy_path, reconcile = "bu";
+    bool kalman = false;
+    double period = 0.0;
     // 參數解析
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
@@ -168,23 +1149,170 @@ int main(int argc, char* argv[]) {
 
         else if ((arg == "--n_steps" || arg == "-n") && i + 1 < argc) n_steps = std::stoi(argv[++i]);
         else if (arg.find("--n_steps=") == 0) n_steps = std::stoi(arg.substr(10));
+
+        else if (arg == "--batch" || arg == "-b") batch = true;
+        else if (arg == "--stream") stream = true;
+        else if (arg == "--bench") bench = true;
+        else if (arg == "--convert") convert = true;
+        else if (arg == "--alloc-check") alloc_check = true;
+        else if (arg == "--obs" && i + 1 < argc) obs_path = argv[++i];
+        else if (arg.find("--obs=") == 0) obs_path = arg.substr(6);
+        else if (arg == "--horizons" && i + 1 < argc) { if (!parse_horizons(argv[++i], horizons)) return 1; }
+        else if (arg == "--intervals") interval_levels = {80, 95};
+        else if (arg.find("--intervals=") == 0) {
+            std::stringstream ss(arg.substr(12));
+            for (std::string f; std::getline(ss, f, ',');) interval_levels.push_back(std::stoi(f));
+        }
+        else if (arg == "--refit") refit = true;
+        else if (arg == "--backtest") backtest = true;
+        else if (arg.find("--threads=") == 0) n_threads = std::stoi(arg.substr(10));
+        else if (arg == "--simd") simd = "double";
+        else if (arg.find("--simd=") == 0) simd = arg.substr(7);
+        else if (arg.find("--lanes=") == 0) lanes = std::stoi(arg.substr(8));
+        else if (arg == "--precision-check") precision_check = true;
+        else if (arg.find("--precision=") == 0) precision = arg.substr(12);
+        else if (arg.find("--tolerance=") == 0) tolerance = std::stod(arg.substr(12));
+        else if (arg.find("--exog=") == 0) exog_path = arg.substr(7);
+        else if (arg.find("--exog-future=") == 0) exog_future_path = arg.substr(14);
+        else if (arg.find("--state-in=") == 0) state_in = arg.substr(11);
+        else if (arg.find("--state-out=") == 0) state_out = arg.substr(12);
+        else if (arg == "--csv-bench") csv_bench = true;
+        else if (arg.find("--synthetic=") == 0) synthetic_lines = std::stol(arg.substr(12));
+        else if (arg.find("--order=") == 0) {
+            std::stringstream ss(arg.substr(8));
+            for (std::string f; std::getline(ss, f, ',');) order.push_back(std::stoi(f));
+        }
+        else if (arg.find("--acov-state=") == 0) acov_state_path = arg.substr(13);
+        else if (arg.find("--acov-tail=") == 0) acov_tail = std::stoi(arg.substr(12));
+        else if (arg == "--order-search") order_search = true;
+        else if (arg.find("--max-order=") == 0) {
+            std::stringstream ss(arg.substr(12));
+            for (std::string f; std::getline(ss, f, ',');) max_order.push_back(std::stoi(f));
+        }
+        else if (arg.find("--criterion=") == 0) criterion = arg.substr(12);
+        else if (arg == "--hierarchy") hierarchy = true;
+        else if (arg.find("--hierarchy=") == 0) { hierarchy = true; hierarchy_path = arg.substr(12); }
+        else if (arg.find("--reconcile=") == 0) reconcile = arg.substr(12);
+        else if (arg == "--kalman") kalman = true;
+        else if (arg.find("--period=") == 0) period = std::stod(arg.substr(9));
+        else if (arg.find("--horizons=") == 0) { if (!parse_horizons(arg.substr(11), horizons)) return 1; }
+    }
+
+    if (csv_bench && !input_path.empty()) return run_csv_bench(input_path, synthetic_lines);
+
+    if (bench && !horizons.empty() && !model_path.empty() && !input_path.empty())
+        return run_horizons(model_path, input_path, output_path.empty() ? "/dev/null" : output_path, horizons, true);
+
+    if (bench && !batch && !model_path.empty() && !input_path.empty())
+        return run_kernel_bench(model_path, input_path, n_steps);
+
+#ifdef ARIMA_ALLOC_CHECK
+    if (alloc_check) return run_alloc_check(model_path, input_path);
+#else
+    if (alloc_check) { std::cerr << "Rebuild with -DARIMA_ALLOC_CHECK to use --alloc-check\n"; return 1; }
+#endif
+
+    if (backtest && !model_path.empty() && !input_path.empty() && !output_path.empty())
+        return run_backtest(model_path, input_path, output_path, n_steps, n_threads);
+
+    if (precision_check && !model_path.empty() && !input_path.empty())
+        return run_precision_check(model_path, input_path, output_path, n_steps, tolerance);
+
+    if (refit && !input_path.empty() && !output_path.empty())
+        return run_refit(model_path, input_path, output_path, order, acov_state_path, acov_tail);
+
+    if (order_search && !input_path.empty() && !output_path.empty())
+        return run_order_search(input_path, output_path, max_order, criterion, n_threads);
+
+    if (convert && !model_path.empty() && !output_path.empty()) {
+        ArimaParams m;
+        if (!parse_arima_params(load_arima_model(model_path), m) || !write_arima_bin(output_path, m)) return 1;
+        std::cout << "Converted " << model_path << " -> " << output_path << std::endl;
+        return 0;
     }
 
     if (model_path.empty() || input_path.empty() || output_path.empty()) {
-        std::cerr << "Usage: ./run_model --model=<model_file_path> --input=<input_file_path> --output=<output_file_path> --n_steps=<num_preds_points>\nOR ./run_model -m <model_file_path> -i <input_file_path> -o <output_file_path> -n <num_preds_points>\n";
+        std::cerr << "Usage: ./run_model --model=<model_file_path> --input=<input_file_path> --output=<output_file_path> --n_steps=<num_preds_points>\nOR ./run_model -m <model_file_path> -i <input_file_path> -o <output_file_path> -n <num_preds_points>\n"
+                     "Batch: add --batch; input = multi-column CSV or directory of CSVs, model = model.csv or directory of <series>.csv\n"
+                     "       [--simd[=double|float] --lanes=4|8|16] runs series in SIMD lanes (AVX2/NEON), --bench compares with scalar\n"
+                     "Hierarchy: add --hierarchy[=groups.csv] (lines 'group,member,...') [--reconcile=bu|ols|mint]; output = series then groups\n"
+                     "Kalman: add --kalman; input = 'timestamp,value' lines (epoch seconds or YYYY-MM-DD HH:MM:SS), gaps and empty values are missing [--period=<s>]\n"
+                     "Stream: add --stream [--obs=<fifo|->]; input = warm-up history, one observation per line, output '-' = stdout\n"
+                     "Bench: --bench -m <model> -i <input> -n <steps> (generic vs specialized kernel)\n"
+                     "Convert: --convert -m model.csv -o model.bin (any --model may then be a .bin)\n"
+                     "Horizons: --horizons=1,60,900,21600 writes 'h,forecast' rows via companion-matrix powers (add --bench to verify)\n"
+                     "Intervals: --intervals[=80,95] adds lower/upper columns from sigma2 and psi-weights\n"
+                     "Refit: --refit --order=p,d,q (or -m old.csv) -i history.csv -o new.csv [--acov-state=acov.bin] [--acov-tail=500]\n"
+                     "Order search: --order-search -i history.csv -o model.csv [--max-order=5,2,5] [--criterion=aic|bic] [--threads=N]\n"
+                     "Backtest: --backtest -m model -i data_samples_28k.csv -o report.csv -n <steps> [--threads=N]\n"
+                     "Precision: --precision=double|float|q16|q32; --precision-check -m model -i data_samples_28k.csv [-o drift.csv] [--tolerance=X]\n"
+                     "ARIMAX: model with order_x/beta*; --exog=<csv aligned with input> --exog-future=<csv with n_steps rows>\n"
+                     "State: --state-out=state.bin saves the forecaster state; --state-in=state.bin resumes from it, input = new points only\n"
+                     "CSV bench: --csv-bench -i <csv> [--synthetic=<lines> writes that many lines to <csv> first]\n";
         return 1;
     }
 
-    std::cout << "model_path: " << model_path << std::endl;
-    std::cout << "input_path: " << input_path << std::endl;
-    std::cout << "output_path: " << output_path << std::endl;
-    std::cout << "n_steps: " << n_steps << std::endl;
+    std::ostream& info = (stream && output_path == "-") ? std::cerr : std::cout;   // stdout 留給預測
+    info << "model_path: " << model_path << std::endl;
+    info << "input_path: " << input_path << std::endl;
+    info << "output_path: " << output_path << std::endl;
+    info << "n_steps: " << n_steps << std::endl;
 
-    auto model = load_arima_model(model_path);
-    auto history = load_history(input_path);
+    if (kalman) {
+        int rc = run_kalman(model_path, input_path, output_path, n_steps, period);
+        if (rc == 0) std::cout << "Done" << std::endl;
+        return rc;
+    }
+
+    if (stream) return run_stream(model_path, input_path, obs_path, output_path, n_steps);
+
+    if (!horizons.empty()) {
+        int rc = run_horizons(model_path, input_path, output_path, horizons, false);
+        if (rc == 0) std::cout << "Done" << std::endl;
+        return rc;
+    }
+
+    if (hierarchy) {
+        int rc = run_hierarchy(model_path, input_path, hierarchy_path, output_path, n_steps, reconcile);
+        if (rc == 0) std::cout << "Done" << std::endl;
+        return rc;
+    }
+
+    if (batch) {
+        int rc = run_batch(model_path, input_path, output_path, n_steps, simd, lanes, bench);
+        if (rc == 0) std::cout << "Done" << std::endl;
+        return rc;
+    }
+
+    ArimaModelHandle model;
+    if (!open_arima_model(model_path, model)) return 1;
+    if (model.extended()) {
+        if (!interval_levels.empty() || precision != "double")
+            std::cerr << "Warning: --intervals / --precision are ignored for seasonal and exogenous models\n";
+        int rc = run_sarimax(model.params, input_path, exog_path, exog_future_path, output_path, n_steps);
+        if (rc == 0) std::cout << "Done" << std::endl;
+        return rc;
+    }
     std::vector<double> forecast;
-    arima_forecast(model, history, n_steps, forecast);
-    write_forecast(output_path, forecast);
+    if (!state_in.empty() || !state_out.empty()) {
+        if (precision != "double") {                // 快照以 double 狀態保存，不提供其他運算型別
+            std::cerr << "Error: --precision=" << precision << " cannot be combined with --state-in / --state-out\n";
+            return 1;
+        }
+        if (!forecast_with_state(model.view, input_path, state_in, state_out, n_steps, forecast)) return 1;
+    } else {
+        auto history = load_history_tail(input_path, size_t(std::max(model.view.p + model.view.d, 1)));   // 只需最後 p+d 筆
+        if (!arima_forecast_precision(precision, model.view, history, n_steps, forecast)) return 1;
+    }
+    if (!interval_levels.empty() && int(forecast.size()) == n_steps) {
+        ArimaIntervals iv;
+        if (!iv.init(model.view, n_steps, interval_levels)) return 1;
+        std::vector<double> bands(2 * interval_levels.size() * size_t(n_steps));
+        iv.apply(forecast, bands);
+        write_forecast_intervals(output_path, forecast, iv, bands);
+    } else {
+        write_forecast(output_path, forecast);
+    }
     std::cout << "Done" << std::endl;
     return 0;
 }
@@ -0,0 +1,15 @@
+#pragma once
+//------------------------------------------------------------
+// 由 cpp/tools/gen_op_resolver.py 產生，請勿手動修改。來源模型：
+//   ar_dnn-w10-l16-l32-l16_windfarm_0620.tflite
+// 只註冊上述模型用到的 builtin op；以 -DTFLITE_MINIMAL_OPS 編譯時取代 BuiltinOpResolver
+//------------------------------------------------------------
+#include "tensorflow/lite/kernels/builtin_op_kernels.h"
+#include "tensorflow/lite/mutable_op_resolver.h"
+
+class MinimalOpResolver : public tflite::MutableOpResolver {
+public:
+    MinimalOpResolver() {
+        AddBuiltin(tflite::BuiltinOperator_FULLY_CONNECTED, tflite::ops::builtin::Register_FULLY_CONNECTED(), 1, 1);
+    }
+};
@@ -0,0 +1,693 @@
+#pragma once
+//------------------------------------------------------------
+// ARIMA 預測函式庫 (header-only)：由 arima_cpp_demo 的 main.cpp 抽出，
+// 供資料擷取程序直接嵌入呼叫，不需另起 run_model 子程序。
+//   模型物件  : ArimaModelHandle ‒ open("model.csv" / "model.bin") 或 assign(ArimaParams)
+//   預測器物件: ArimaForecaster  ‒ init(view, history) 一次配置，之後
+//               forecast(out) / observe(y) 只讀寫呼叫端緩衝，不配置記憶體、不做 I/O 或字串解析
+// 其他模型與工具在同目錄的 arima_*.h：固定階數核心 (arima_fixed.h)、多序列批次與 SIMD lane
+// (arima_batch.h)、SARIMA / ARIMAX (arima_sarimax.h)、跳躍預測與預測區間 (arima_horizon.h)、
+// Kalman (arima_kalman.h)、重新估計與階數搜尋 (arima_fit.h)、階層調和 (arima_hierarchy.h)
+// 例：
+//   ArimaModelHandle model;  model.open("model.csv");
+//   ArimaForecaster f;       f.init(model.view, Span<const double>(history));
+//   f.observe(y_new);        f.forecast(Span<double>(out, 25));
+//------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <filesystem>
+#include <fstream>
+#include <iostream>
+#include <limits>
+#include <string>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+#include "span.h"
+
+// 讀取 ARIMA 權重
+inline std::unordered_map<std::string, double> load_arima_model(const std::string& filename) {
+    std::unordered_map<std::string, double> model;
+    std::ifstream file(filename);
+    std::string line;
+    while (std::getline(file, line)) {
+        size_t comma = line.find(',');
+        if (comma == std::string::npos) continue;
+        std::string key = line.substr(0, comma);
+        double val = std::stod(line.substr(comma + 1));
+        model[key] = val;
+    }
+    return model;
+}
+
+struct ArimaParams {
+    int p = 0, d = 0, q = 0;
+    double mu = 0.0, sigma2 = 0.0;
+    std::vector<double> phi, theta, eps;
+    int P = 0, D = 0, Q = 0, s = 0;            // 季節項 (P,D,Q)_s；s ≤ 1 或全 0 表示無季節
+    std::vector<double> sphi, stheta;          // [P] / [Q]
+    int k = 0;                                 // 外生變數個數 (ARIMAX)
+    std::vector<double> beta;                  // [k] 迴歸係數，順序同 --exog 的欄
+    bool seasonal() const { return s > 1 && (P > 0 || D > 0 || Q > 0); }
+    bool extended() const { return seasonal() || k > 0; }
+};
+
+// 把 key/value 模型轉成固定欄位，之後的批次運算不再查字串
+inline bool parse_arima_params(const std::unordered_map<std::string, double>& model, ArimaParams& out) {
+    if (!model.count("order_p") || !model.count("order_d") || !model.count("order_q")) {
+        std::cerr << "Error: model lacks order_p/order_d/order_q\n";
+        return false;
+    }
+    out.p = int(model.at("order_p"));
+    out.d = int(model.at("order_d"));
+    out.q = int(model.at("order_q"));
+    if (out.p < 0 || out.d < 0 || out.q < 0) {
+        std::cerr << "Error: p/d/q must be ≥ 0\n";
+        return false;
+    }
+    out.mu     = model.count("mu")     ? model.at("mu")     : 0.0;
+    out.sigma2 = model.count("sigma2") ? model.at("sigma2") : 0.0;
+    out.phi.assign(out.p, 0.0);
+    out.theta.assign(out.q, 0.0);
+    out.eps.assign(out.q, 0.0);
+    for (int i = 0; i < out.p; ++i)
+        if (auto it = model.find("phi" + std::to_string(i + 1)); it != model.end())
+            out.phi[i] = it->second;
+    for (int j = 0; j < out.q; ++j) {
+        if (auto it = model.find("theta" + std::to_string(j + 1)); it != model.end()) out.theta[j] = it->second;
+        if (auto it = model.find("eps"   + std::to_string(j + 1)); it != model.end()) out.eps[j]   = it->second;
+    }
+
+    /* 選填季節項：seasonal_P/D/Q/s，係數 sphi1..P、stheta1..Q */
+    auto get = [&](const char* key) { return model.count(key) ? int(model.at(key)) : 0; };
+    out.P = get("seasonal_P");
+    out.D = get("seasonal_D");
+    out.Q = get("seasonal_Q");
+    out.s = get("seasonal_s");
+    if (out.P < 0 || out.D < 0 || out.Q < 0 || ((out.P || out.D || out.Q) && out.s < 2)) {
+        std::cerr << "Error: seasonal_P/D/Q must be ≥ 0 and seasonal_s ≥ 2\n";
+        return false;
+    }
+    out.sphi.assign(out.P, 0.0);
+    out.stheta.assign(out.Q, 0.0);
+    for (int k = 0; k < out.P; ++k)
+        if (auto it = model.find("sphi" + std::to_string(k + 1)); it != model.end()) out.sphi[k] = it->second;
+    for (int k = 0; k < out.Q; ++k)
+        if (auto it = model.find("stheta" + std::to_string(k + 1)); it != model.end()) out.stheta[k] = it->second;
+
+    /* 選填外生迴歸：order_x 個係數 beta1..beta_x */
+    out.k = get("order_x");
+    if (out.k < 0) {
+        std::cerr << "Error: order_x must be ≥ 0\n";
+        return false;
+    }
+    out.beta.assign(out.k, 0.0);
+    for (int j = 0; j < out.k; ++j)
+        if (auto it = model.find("beta" + std::to_string(j + 1)); it != model.end()) out.beta[j] = it->second;
+    return true;
+}
+
+/* 不持有記憶體的模型視圖：係數可指向 ArimaParams 的 vector 或 mmap 的 .bin 檔 */
+struct ArimaModelView {
+    int p = 0, d = 0, q = 0;
+    double mu = 0.0, sigma2 = 0.0;
+    const double* phi   = nullptr;
+    const double* theta = nullptr;
+    const double* eps   = nullptr;
+};
+
+inline ArimaModelView view_of(const ArimaParams& m) {
+    return {m.p, m.d, m.q, m.mu, m.sigma2, m.phi.data(), m.theta.data(), m.eps.data()};
+}
+
+// 模型指紋 (FNV-1a 64，涵蓋階數與所有係數)，狀態快照以此拒絕不同模型
+inline uint64_t arima_model_hash(const ArimaModelView& m) {
+    uint64_t h = 14695981039346656037ull;
+    auto mix = [&](const void* data, size_t bytes) {
+        const unsigned char* b = static_cast<const unsigned char*>(data);
+        for (size_t i = 0; i < bytes; ++i) { h ^= b[i]; h *= 1099511628211ull; }
+    };
+    const int32_t order[3] = {m.p, m.d, m.q};
+    mix(order, sizeof(order));
+    mix(&m.mu, sizeof(m.mu));
+    mix(&m.sigma2, sizeof(m.sigma2));
+    mix(m.phi,   sizeof(double) * m.p);
+    mix(m.theta, sizeof(double) * m.q);
+    mix(m.eps,   sizeof(double) * m.q);
+    return h;
+}
+
+//------------------------------------------------------------
+// 二進位模型格式 (.bin) ‒ 固定 header + 連續 phi[p] theta[q] eps[q]
+// (native-endian double)；以單次 pread (大檔 mmap) 載入，不配置記憶體、不做字串查找
+//------------------------------------------------------------
+inline constexpr char     kArimaBinMagic[4] = {'A', 'R', 'M', 'B'};
+inline constexpr uint32_t kArimaBinVersion  = 1;
+
+struct ArimaBinHeader {
+    char     magic[4];            // "ARMB"
+    uint32_t version;             // kArimaBinVersion
+    int32_t  p, d, q;
+    uint32_t header_bytes;        // sizeof(ArimaBinHeader)，之後的陣列由此起算
+    double   mu, sigma2;
+};
+static_assert(sizeof(ArimaBinHeader) % alignof(double) == 0, "arrays after header must stay aligned");
+
+// 以 model.csv 相同欄位寫回 (order_p/d/q, mu, sigma2, phi*, theta*, eps*)
+inline bool write_arima_csv(const std::string& filename, const ArimaParams& m) {
+    std::ofstream file(filename);
+    if (!file.is_open()) {
+        std::cerr << "Cannot write model: " << filename << '\n';
+        return false;
+    }
+    file.precision(17);
+    file << "order_p," << m.p << "\norder_d," << m.d << "\norder_q," << m.q << "\n"
+         << "mu," << m.mu << "\nsigma2," << m.sigma2 << "\n";
+    for (int i = 0; i < m.p; ++i) file << "phi"   << i + 1 << "," << m.phi[i]   << "\n";
+    for (int j = 0; j < m.q; ++j) file << "theta" << j + 1 << "," << m.theta[j] << "\n";
+    for (int j = 0; j < m.q; ++j) file << "eps"   << j + 1 << "," << m.eps[j]   << "\n";
+    if (m.seasonal()) {
+        file << "seasonal_P," << m.P << "\nseasonal_D," << m.D << "\nseasonal_Q," << m.Q
+             << "\nseasonal_s," << m.s << "\n";
+        for (int k = 0; k < m.P; ++k) file << "sphi"   << k + 1 << "," << m.sphi[k]   << "\n";
+        for (int k = 0; k < m.Q; ++k) file << "stheta" << k + 1 << "," << m.stheta[k] << "\n";
+    }
+    if (m.k > 0) {
+        file << "order_x," << m.k << "\n";
+        for (int j = 0; j < m.k; ++j) file << "beta" << j + 1 << "," << m.beta[j] << "\n";
+    }
+    return bool(file);
+}
+
+// model.csv → model.bin
+inline bool write_arima_bin(const std::string& filename, const ArimaParams& m) {
+    if (m.extended()) {
+        std::cerr << "Error: the binary model format has no seasonal or exogenous terms\n";
+        return false;
+    }
+    std::ofstream file(filename, std::ios::binary);
+    if (!file.is_open()) {
+        std::cerr << "Cannot write model: " << filename << '\n';
+        return false;
+    }
+    ArimaBinHeader h{};
+    std::copy(kArimaBinMagic, kArimaBinMagic + 4, h.magic);
+    h.version      = kArimaBinVersion;
+    h.p            = m.p;
+    h.d            = m.d;
+    h.q            = m.q;
+    h.header_bytes = sizeof(ArimaBinHeader);
+    h.mu           = m.mu;
+    h.sigma2       = m.sigma2;
+    file.write(reinterpret_cast<const char*>(&h), sizeof(h));
+    file.write(reinterpret_cast<const char*>(m.phi.data()),   sizeof(double) * m.p);
+    file.write(reinterpret_cast<const char*>(m.theta.data()), sizeof(double) * m.q);
+    file.write(reinterpret_cast<const char*>(m.eps.data()),   sizeof(double) * m.q);
+    return bool(file);
+}
+
+/* 唯讀載入 .bin；view() 直接指向載入的位元組，物件存活期間有效。
+ * 小檔 (≤ kInline，一般的 p/q 都是) 以一次 pread 讀進物件內的緩衝，省去 fstat/mmap/munmap 與缺頁；
+ * 較大的檔才 mmap 整個檔案 */
+class MappedArimaModel {
+public:
+    MappedArimaModel() = default;
+    MappedArimaModel(const MappedArimaModel&) = delete;
+    MappedArimaModel& operator=(const MappedArimaModel&) = delete;
+    MappedArimaModel(MappedArimaModel&& o) noexcept { *this = std::move(o); }
+    MappedArimaModel& operator=(MappedArimaModel&& o) noexcept {
+        if (this == &o) return *this;
+        release();
+        std::swap(base_, o.base_);
+        std::swap(size_, o.size_);
+        if (!base_) std::copy(o.inline_, o.inline_ + size_, inline_);
+        if (size_) bind();
+        o.release();
+        return *this;
+    }
+    ~MappedArimaModel() { release(); }
+
+    bool open(const std::string& filename) {
+        release();
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) { std::cerr << "Cannot open model: " << filename << '\n'; return false; }
+        const ssize_t got = ::pread(fd, inline_, sizeof(inline_), 0);
+        if (got >= 0 && size_t(got) < sizeof(inline_)) {
+            size_ = size_t(got);                   // 整個檔已在 inline_
+        } else {
+            struct stat st {};
+            void* base = MAP_FAILED;
+            if (got >= 0 && fstat(fd, &st) == 0)
+                base = mmap(nullptr, size_t(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+            if (base == MAP_FAILED) { ::close(fd); std::cerr << "Cannot read model: " << filename << '\n'; return false; }
+            base_ = base;
+            size_ = size_t(st.st_size);
+        }
+        ::close(fd);
+
+        if (size_ < sizeof(ArimaBinHeader)) {
+            std::cerr << "Error: " << filename << " is too small for an ARIMA model\n";
+            release();
+            return false;
+        }
+        const auto* h = reinterpret_cast<const ArimaBinHeader*>(data());
+        if (!std::equal(kArimaBinMagic, kArimaBinMagic + 4, h->magic) || h->version != kArimaBinVersion) {
+            std::cerr << "Error: " << filename << " is not an ARIMA v" << kArimaBinVersion << " binary model\n";
+            release();
+            return false;
+        }
+        if (h->p < 0 || h->d < 0 || h->q < 0 || h->header_bytes < sizeof(ArimaBinHeader)
+            || h->header_bytes % alignof(double) != 0
+            || size_ < h->header_bytes + sizeof(double) * (size_t(h->p) + 2 * size_t(h->q))) {
+            std::cerr << "Error: " << filename << " has an invalid header\n";
+            release();
+            return false;
+        }
+        bind();
+        return true;
+    }
+
+    const ArimaModelView& view() const { return view_; }
+    bool loaded() const { return size_ != 0; }
+
+private:
+    static constexpr size_t kInline = 1024;
+
+    const char* data() const { return base_ ? static_cast<const char*>(base_) : inline_; }
+
+    // 由已驗證的 header 建 view (移動後 inline_ 位址改變，需重建)
+    void bind() {
+        const auto* h = reinterpret_cast<const ArimaBinHeader*>(data());
+        const double* arr = reinterpret_cast<const double*>(data() + h->header_bytes);
+        view_ = {h->p, h->d, h->q, h->mu, h->sigma2, arr, arr + h->p, arr + h->p + h->q};
+    }
+
+    void release() {
+        if (base_) munmap(base_, size_);
+        base_ = nullptr;
+        size_ = 0;
+        view_ = ArimaModelView{};
+    }
+
+    void*          base_ = nullptr;            // mmap 區；nullptr 時資料在 inline_
+    size_t         size_ = 0;
+    ArimaModelView view_;
+    alignas(double) char inline_[kInline];
+};
+
+/* 模型物件：依副檔名載入 (*.bin → mmap；其餘視為 model.csv)，或由呼叫端填好的 ArimaParams 建立。
+ * 以 view 取用係數；handle 須在 view 使用期間存活 (可移動、不可複製)。
+ * 季節 / 外生變數模型 (extended()) 也可載入：view 只含非季節的 ARMA 部分，
+ * 完整係數在 params，交給 SarimaForecaster / exog_regression() (arima_sarimax.h) */
+struct ArimaModelHandle {
+    ArimaParams      params;
+    MappedArimaModel mapped;
+    ArimaModelView   view;
+
+    ArimaModelHandle() = default;
+    ArimaModelHandle(ArimaModelHandle&& o) noexcept { *this = std::move(o); }
+    // 小 .bin 存在 mapped 物件內，移動後 view 須改指向新位址
+    ArimaModelHandle& operator=(ArimaModelHandle&& o) noexcept {
+        params = std::move(o.params);
+        const bool from_file = o.mapped.loaded();
+        mapped = std::move(o.mapped);
+        view = from_file ? mapped.view() : o.view;
+        return *this;
+    }
+
+    bool open(const std::string& filename);
+    // 不經檔案：直接採用係數 (嵌入的程序自行保存 / 下發模型時使用)
+    bool assign(ArimaParams m) {
+        if (m.p < 0 || m.d < 0 || m.q < 0 || int(m.phi.size()) != m.p
+            || int(m.theta.size()) != m.q || int(m.eps.size()) != m.q) {
+            std::cerr << "Error: phi/theta/eps sizes must match p/q\n";
+            return false;
+        }
+        if (m.P < 0 || m.D < 0 || m.Q < 0 || m.k < 0 || ((m.P || m.D || m.Q) && m.s < 2)
+            || int(m.sphi.size()) != m.P || int(m.stheta.size()) != m.Q || int(m.beta.size()) != m.k) {
+            std::cerr << "Error: sphi/stheta/beta sizes must match P/Q/order_x and seasonal_s must be ≥ 2\n";
+            return false;
+        }
+        params = std::move(m);
+        view = view_of(params);
+        return true;
+    }
+    // 有季節或外生項：只吃 view 的路徑 (ArimaForecaster、批次、Kalman…) 不適用
+    bool extended() const { return params.extended(); }
+};
+
+inline bool open_arima_model(const std::string& filename, ArimaModelHandle& h) {
+    if (std::filesystem::path(filename).extension() == ".bin") {
+        h.params = ArimaParams{};
+        if (!h.mapped.open(filename)) return false;
+        h.view = h.mapped.view();
+        return true;
+    }
+    if (!parse_arima_params(load_arima_model(filename), h.params)) return false;
+    h.view = view_of(h.params);
+    return true;
+}
+
+inline bool ArimaModelHandle::open(const std::string& filename) { return open_arima_model(filename, *this); }
+
+//------------------------------------------------------------
+// ARIMA(p,d,q) rolling forecast ‒ 支援 d = 0/1/…、p 或 q = 0
+// 原始的 key/value 版本：每次呼叫查字串、配置記憶體，保留作為其他路徑的比對基準
+//------------------------------------------------------------
+inline void arima_forecast(
+    const std::unordered_map<std::string, double>& model,
+    const std::vector<double>& history,
+    int n_steps,
+    std::vector<double>& out_forecast
+) {
+    /* ---------- 0. 讀模型參數 ---------- */
+    const int p = int(model.at("order_p"));
+    const int d = int(model.at("order_d"));
+    const int q = int(model.at("order_q"));
+    const double mu = model.count("mu") ? model.at("mu") : 0.0;
+
+    if (p < 0 || d < 0 || q < 0) {                 // ★ 允許 p = 0，但不得為負
+        std::cerr << "Error: p/d/q must be ≥ 0\n";
+        return;
+    }
+
+    /* ---------- 1. 檢查並裁剪歷史 ---------- */
+    const int need = p + d;                        // 公式最少需要 p+d 筆 y
+    if (int(history.size()) < need) {              // ★ 修正括號 bug
+        std::cerr << "Error: history length < p + d = " << need << '\n';
+        return;
+    }
+    std::vector<double> hist(history.end() - need, history.end());
+
+    /* ---------- 2. 讀 φ / θ / ε ---------- */
+    std::vector<double> phi(p, 0.0), theta(q, 0.0), eps(q, 0.0);
+    for (int i = 0; i < p; ++i)
+        if (auto it = model.find("phi" + std::to_string(i + 1)); it != model.end())
+            phi[i] = it->second;
+
+    for (int j = 0; j < q; ++j) {
+        auto tkey = "theta" + std::to_string(j + 1);
+        auto ekey = "eps"   + std::to_string(j + 1);
+        if (auto it = model.find(tkey); it != model.end()) theta[j] = it->second;
+        if (auto it = model.find(ekey); it != model.end()) eps[j]   = it->second;
+    }
+
+    /* ---------- 3. 差分序列 ---------- */
+    std::vector<std::vector<double>> diff(d);      // diff[k] = Δ^{k+1}y
+    if (d > 0) {
+        diff[0].reserve(hist.size() - 1);
+        for (size_t i = 1; i < hist.size(); ++i)
+            diff[0].push_back(hist[i] - hist[i - 1]);
+
+        for (int k = 1; k < d; ++k) {
+            const auto& prev = diff[k - 1];
+            diff[k].reserve(prev.size() - 1);
+            for (size_t i = 1; i < prev.size(); ++i)
+                diff[k].push_back(prev[i] - prev[i - 1]);
+        }
+    }
+    /* ★ d==0 時 diff_d 指向 hist；d>0 指向 Δ^d y 序列 */
+    std::vector<double>& diff_d = (d == 0) ? hist : diff.back();
+
+    /* ---------- 4. 最新 y_t ---------- */
+    double last_level = hist.back();               // 原始尺度最新值
+
+    /* ---------- 5. Forecast loop ---------- */
+    for (int step = 0; step < n_steps; ++step) {
+
+        /* 5-1  AR 部分：φ ⋅ (y or Δ^d y) */
+        double ar_sum = 0.0;
+        for (int i = 0; i < p; ++i)
+            ar_sum += phi[i] * diff_d[diff_d.size() - 1 - i];
+
+        /* 5-2  MA 部分：θ ⋅ ε */
+        double ma_sum = 0.0;
+        for (int j = 0; j < q; ++j)
+            ma_sum += theta[j] * eps[j];
+
+        /* 5-3  差分層級預測值 */
+        double diff_d_hat = mu + ar_sum + ma_sum;
+
+        /* 5-4  把 diff_d_hat 推回原始尺度 ---------------------- */
+        double y_hat;
+        if (d == 0) {                              // ★ 無差分：直接相加
+            y_hat = last_level + diff_d_hat;
+        } else {
+            /* 逐層累加：new_diff[k] = diff[k].back() + carry */
+            double carry = diff_d_hat;             // 從 Δ^d ŷ 開始
+            for (int k = d - 1; k >= 1; --k) {     // k = d-1 … 1
+                double new_diff = diff[k - 1].back() + carry;
+                diff[k - 1].push_back(new_diff);   // 追加到對應差分序列
+                carry = new_diff;                  // 傳給下一層
+            }
+            y_hat = last_level + carry;            // 最後 carry = Δŷ
+        }
+
+        /* 5-5  更新狀態 / 序列 / 殘差 ------------------------ */
+        last_level = y_hat;
+        diff_d.push_back((d == 0) ? y_hat : diff_d_hat); // AR 需要
+
+        if (q > 0) {                           // ε_{t+1} 期望 0 → 入首
+            eps.insert(eps.begin(),0.0);
+            eps.pop_back();
+        }
+
+        out_forecast.push_back(y_hat);
+    }
+}
+
+//------------------------------------------------------------
+// Q 格式定點數：Rep 存整數、低 F 位為小數，乘法以 Wide 暫存後四捨五入右移，
+// 加減與乘積超出 Rep 範圍時飽和。供無 (或弱) FPU 的 ARM 面板使用
+//------------------------------------------------------------
+template <typename Rep, typename Wide, int F>
+struct FixedPoint {
+    Rep v = 0;
+    FixedPoint() = default;
+    explicit FixedPoint(double x) : v(from_double(x)) {}
+    explicit operator double() const { return double(v) / double(Wide(1) << F); }
+
+    static Rep from_double(double x) {
+        const double scaled = x * double(Wide(1) << F);
+        if (scaled >= double(std::numeric_limits<Rep>::max())) return std::numeric_limits<Rep>::max();
+        if (scaled <= double(std::numeric_limits<Rep>::min())) return std::numeric_limits<Rep>::min();
+        return Rep(std::llround(scaled));
+    }
+
+    static Rep saturate(Wide w) {
+        if (w > Wide(std::numeric_limits<Rep>::max())) return std::numeric_limits<Rep>::max();
+        if (w < Wide(std::numeric_limits<Rep>::min())) return std::numeric_limits<Rep>::min();
+        return Rep(w);
+    }
+    static FixedPoint raw(Rep r) { FixedPoint f; f.v = r; return f; }
+
+    friend FixedPoint operator+(FixedPoint a, FixedPoint b) { return raw(saturate(Wide(a.v) + b.v)); }
+    friend FixedPoint operator-(FixedPoint a, FixedPoint b) { return raw(saturate(Wide(a.v) - b.v)); }
+    friend FixedPoint operator*(FixedPoint a, FixedPoint b) {
+        return raw(saturate((Wide(a.v) * b.v + (Wide(1) << (F - 1))) >> F));
+    }
+    FixedPoint& operator+=(FixedPoint b) { return *this = *this + b; }
+    FixedPoint& operator-=(FixedPoint b) { return *this = *this - b; }
+};
+using FixedQ16 = FixedPoint<int32_t, int64_t, 16>;      // Q15.16：±32768，解析度 1.5e-5
+using FixedQ32 = FixedPoint<int64_t, __int128, 32>;     // Q31.32：±2^31，解析度 2.3e-10
+
+//------------------------------------------------------------
+// 可重複使用的單序列預測器 ‒ init() 依 p/d/q 配置固定容量的環狀緩衝，
+// 之後 forecast() / observe() 不再配置記憶體，輸出寫入呼叫端的緩衝區。
+// T = 內部運算型別 (double / float / FixedQ16 / FixedQ32)；介面仍以 double 進出，
+// T = double 時與 arima_forecast() 逐位元相同
+//------------------------------------------------------------
+template <typename T>
+class BasicArimaForecaster {
+public:
+    bool init(const ArimaModelView& m, const double* history, size_t len) {
+        const int need = m.p + m.d;
+        if (int(len) < std::max(need, 1)) {
+            std::cerr << "Error: history length < p + d = " << need << '\n';
+            return false;
+        }
+        allocate(m);
+        reset(history, len);
+        return true;
+    }
+
+    /* 狀態快照：header "ARST" + {版本, p, d, q} + 模型指紋，
+     * 之後 lag[p]、ε[q] (最新 → 最舊)、level[max(d,1)]，皆為 double */
+    bool save_state(const std::string& filename) const {
+        std::ofstream f(filename, std::ios::binary);
+        if (!f.is_open()) { std::cerr << "Cannot write state: " << filename << '\n'; return false; }
+        const int32_t hdr[4] = {kStateVersion, m_.p, m_.d, m_.q};
+        const uint64_t hash = arima_model_hash(m_);
+        f.write("ARST", 4);
+        f.write(reinterpret_cast<const char*>(hdr), sizeof(hdr));
+        f.write(reinterpret_cast<const char*>(&hash), sizeof(hash));
+        auto put = [&](const T* v, int n) {
+            for (int i = 0; i < n; ++i) {
+                const double x = double(v[i]);
+                f.write(reinterpret_cast<const char*>(&x), sizeof(x));
+            }
+        };
+        put(lags(), m_.p);
+        put(resids(), m_.q);
+        put(levels(), lv_);
+        return bool(f);
+    }
+
+    // 讀回快照作為 m 的目前狀態；指紋不同 (模型已換) 即拒絕
+    bool load_state(const ArimaModelView& m, const std::string& filename) {
+        std::ifstream f(filename, std::ios::binary);
+        if (!f.is_open()) { std::cerr << "Cannot open state: " << filename << '\n'; return false; }
+        char magic[4];
+        int32_t hdr[4];
+        uint64_t hash = 0;
+        f.read(magic, 4);
+        f.read(reinterpret_cast<char*>(hdr), sizeof(hdr));
+        f.read(reinterpret_cast<char*>(&hash), sizeof(hash));
+        if (!f || !std::equal(magic, magic + 4, "ARST") || hdr[0] != kStateVersion) {
+            std::cerr << "Error: " << filename << " is not a forecaster state v" << kStateVersion << '\n';
+            return false;
+        }
+        if (hdr[1] != m.p || hdr[2] != m.d || hdr[3] != m.q || hash != arima_model_hash(m)) {
+            std::cerr << "Error: " << filename << " was saved with a different model\n";
+            return false;
+        }
+        allocate(m);
+        auto get = [&](int n) {
+            std::vector<double> v(n);
+            f.read(reinterpret_cast<char*>(v.data()), sizeof(double) * n);
+            return v;
+        };
+        const auto lag = get(m.p), eps = get(m.q), lvl = get(lv_);
+        if (!f) { std::cerr << "Error: truncated state " << filename << '\n'; return false; }
+        for (int i = m.p - 1; i >= 0; --i) lag_.push_front(T(lag[i]));
+        for (int j = m.q - 1; j >= 0; --j) eps_.push_front(T(eps[j]));
+        for (int k = 0; k < lv_; ++k) lvl_[k] = T(lvl[k]);
+        return true;
+    }
+
+    /* 以另一段歷史重設狀態 (同模型、不重新配置)，len ≥ max(p+d,1)。
+     * 與 arima_forecast() 相同：取最後 max(p+d,1) 筆，逐層差分並記下每層最新值 */
+    void reset(const double* history, size_t len) {
+        const int W = int(work_.size());
+        for (int i = 0; i < W; ++i) work_[i] = T(history[len - W + i]);
+        lvl_[0] = work_[W - 1];
+        for (int k = 1; k <= m_.d; ++k) {          // 第 k 次差分後有效區段為 work[k..W-1]
+            for (int i = W - 1; i >= k; --i) work_[i] -= work_[i - 1];
+            if (k < m_.d) lvl_[k] = work_[W - 1];
+        }
+        lag_.head = eps_.head = 0;
+        for (int i = m_.p - 1; i >= 0; --i) lag_.push_front(work_[W - 1 - i]);
+        for (int j = m_.q - 1; j >= 0; --j) eps_.push_front(T(m_.eps[j]));
+    }
+
+    // 從目前狀態往後預測 n_steps 步寫入 out[0..n_steps)；不改變已觀測狀態
+    void forecast(double* out, int n_steps) {
+        s_lag_.copy_from(lag_);
+        s_eps_.copy_from(eps_);
+        std::copy(lvl_.begin(), lvl_.end(), s_lvl_.begin());
+        for (int step = 0; step < n_steps; ++step) {
+            const T diff_d_hat = predict(s_lag_, s_eps_);
+            T carry = diff_d_hat;
+            for (int k = lv_ - 1; k >= 0; --k) {
+                s_lvl_[k] += carry;
+                carry = s_lvl_[k];
+            }
+            s_lag_.push_front(m_.d == 0 ? carry : diff_d_hat);
+            s_eps_.push_front(T(0.0));           // ε_{t+1} 期望 0
+            out[step] = double(carry);
+        }
+    }
+
+    // 新的真實觀測：殘差 ε_t = y - ŷ 推入 MA 環，差分狀態前進一格
+    void observe(double y_obs) {
+        const T y = T(y_obs);
+        const T diff_d_hat = predict(lag_, eps_);
+        if (m_.d == 0) {
+            eps_.push_front(y - (lvl_[0] + diff_d_hat));
+            lvl_[0] = y;
+            lag_.push_front(y);
+            return;
+        }
+        T carry = y;
+        for (int k = 0; k < m_.d; ++k) {
+            const T diff = carry - lvl_[k];
+            lvl_[k] = carry;
+            carry = diff;
+        }
+        eps_.push_front(carry - diff_d_hat);
+        lag_.push_front(carry);
+    }
+
+    /* Span 版本：緩衝皆由呼叫端持有，out.size() 即預測步數 */
+    bool init(const ArimaModelView& m, Span<const double> history) { return init(m, history.data(), history.size()); }
+    void forecast(Span<double> out) { forecast(out.data(), int(out.size())); }
+    void observe(Span<const double> ys) { for (double y : ys) observe(y); }
+
+    const ArimaModelView& model() const { return m_; }
+    const T* lags()   const { return lag_.data(); }    // [p]  最新 → 最舊 Δ^d y
+    const T* resids() const { return eps_.data(); }    // [q]  最新 → 最舊 ε
+    const T* levels() const { return lvl_.data(); }    // [max(d,1)] 最新 Δ^k y
+
+private:
+    static constexpr int32_t kStateVersion = 1;
+
+    // 依 p/d/q 配置所有緩衝 (狀態清零)
+    void allocate(const ArimaModelView& m) {
+        const int need = m.p + m.d;
+        m_ = m;
+        lv_ = std::max(m.d, 1);
+        mu_ = T(m.mu);
+        phi_.resize(m.p);
+        theta_.resize(m.q);
+        for (int i = 0; i < m.p; ++i) phi_[i] = T(m.phi[i]);
+        for (int j = 0; j < m.q; ++j) theta_[j] = T(m.theta[j]);
+        lag_.assign(m.p);
+        eps_.assign(m.q);
+        lvl_.assign(lv_, T(0.0));
+        s_lag_.assign(m.p);
+        s_eps_.assign(m.q);
+        s_lvl_.assign(lv_, T(0.0));
+        work_.assign(std::max(need, 1), T(0.0));
+    }
+
+    /* 鏡像環：容量 n、實際長度 2n，每個值同時寫在 i 與 i+n，
+     * 從 head 起連續讀 n 個即為最新 → 最舊，內層點積不需取模 */
+    struct Ring {
+        std::vector<T> buf;
+        int n = 0, head = 0;
+        void assign(int size) { n = size; head = 0; buf.assign(2 * size_t(size), T(0.0)); }
+        const T* data() const { return buf.data() + head; }
+        void push_front(T v) {
+            if (n == 0) return;
+            head = head ? head - 1 : n - 1;
+            buf[head] = buf[head + n] = v;
+        }
+        void copy_from(const Ring& o) { head = o.head; std::copy(o.buf.begin(), o.buf.end(), buf.begin()); }
+    };
+
+    T predict(const Ring& lag, const Ring& eps) const {
+        const T* lg = lag.data();
+        const T* ep = eps.data();
+        T ar_sum = T(0.0);
+        for (int i = 0; i < m_.p; ++i) ar_sum += phi_[i] * lg[i];
+        T ma_sum = T(0.0);
+        for (int j = 0; j < m_.q; ++j) ma_sum += theta_[j] * ep[j];
+        return mu_ + ar_sum + ma_sum;
+    }
+
+    ArimaModelView m_;
+    int lv_ = 1;
+    T mu_ = T(0.0);
+    std::vector<T> phi_, theta_;                 // 係數轉成 T 的副本
+    Ring lag_, eps_, s_lag_, s_eps_;             // s_* = forecast() 用的暫存副本
+    std::vector<T> lvl_, s_lvl_;                 // lvl[k] = 最新 Δ^k y
+    std::vector<T> work_;                        // reset() 差分用暫存
+};
+using ArimaForecaster = BasicArimaForecaster<double>;
@@ -0,0 +1,436 @@
+#pragma once
+//------------------------------------------------------------
+// 多序列批次 ARIMA (header-only)：structure-of-arrays 的純量批次
+// (init_arima_batch / arima_forecast_batch / arima_batch_observe)，
+// 以及同階數序列放進 SIMD lane 的核心 (arima_forecast_lanes，AVX2 / NEON 執行期偵測)。
+// 預測與觀測只讀寫呼叫端緩衝，輸出佈局皆為 [step][series]
+//------------------------------------------------------------
+#include <algorithm>
+#include <iostream>
+#include <string>
+#include <type_traits>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#include <sys/auxv.h>
+#endif
+
+#include "arima.h"
+
+//------------------------------------------------------------
+// 多序列批次 ARIMA ‒ 一次預測整個風場 (每台風機一條序列)
+//------------------------------------------------------------
+/* Structure-of-arrays：每個係數 / 狀態一列，列內依序列排開 ([row][series])，
+ * 內層迴圈跨序列連續存取。p、q 取全部序列最大值，不足處係數補 0。         */
+struct ArimaBatch {
+    int n  = 0;                   // 序列數
+    int p  = 0, q = 0;            // 最大 p / q
+    int lv = 1;                   // 積分層數 = max(d, 1)
+    int lag_head = 0, eps_head = 0;
+    std::vector<int>    d;        // [n]
+    std::vector<double> mu;       // [n]
+    std::vector<double> phi;      // [p][n]
+    std::vector<double> theta;    // [q][n]
+    std::vector<double> eps;      // [q][n]  環狀：第 j 個落後 = 列 (eps_head + j) % q
+    std::vector<double> lag;      // [p][n]  環狀：第 i 個落後 Δ^d y = 列 (lag_head + i) % p
+    std::vector<double> level;    // [lv][n] level[k] = 最新 Δ^k y (k = 0 為原始尺度)
+};
+
+// 各序列歷史 → Span 清單 (不複製)，供 init_arima_batch() / batch_residuals() 使用
+inline std::vector<Span<const double>> series_spans(const std::vector<std::vector<double>>& cols) {
+    return std::vector<Span<const double>>(cols.begin(), cols.end());
+}
+
+inline bool init_arima_batch(
+    const std::vector<ArimaModelView>& params,        // size 1 = 共用模型，否則每條序列一份
+    const std::vector<Span<const double>>& histories, // 每條序列至少 max(p+d,1) 筆
+    const std::vector<std::string>& names,
+    ArimaBatch& b
+) {
+    const int n = int(histories.size());
+    auto par = [&](int s) -> const ArimaModelView& { return params.size() == 1 ? params[0] : params[s]; };
+
+    b = ArimaBatch{};
+    b.n = n;
+    for (int s = 0; s < n; ++s) {
+        b.p  = std::max(b.p, par(s).p);
+        b.q  = std::max(b.q, par(s).q);
+        b.lv = std::max(b.lv, par(s).d);
+    }
+    b.d.resize(n);
+    b.mu.resize(n);
+    b.phi.assign(size_t(b.p) * n, 0.0);
+    b.theta.assign(size_t(b.q) * n, 0.0);
+    b.eps.assign(size_t(b.q) * n, 0.0);
+    b.lag.assign(size_t(b.p) * n, 0.0);
+    b.level.assign(size_t(b.lv) * n, 0.0);
+
+    std::vector<double> work;
+    for (int s = 0; s < n; ++s) {
+        const ArimaModelView& m = par(s);
+        const int need = m.p + m.d;
+        const Span<const double> history = histories[s];
+        if (int(history.size()) < need || history.empty()) {
+            std::cerr << "Error: series " << names[s] << " history length < p + d = " << need << '\n';
+            return false;
+        }
+        b.d[s]  = m.d;
+        b.mu[s] = m.mu;
+        for (int i = 0; i < m.p; ++i) b.phi[size_t(i) * n + s] = m.phi[i];
+        for (int j = 0; j < m.q; ++j) {
+            b.theta[size_t(j) * n + s] = m.theta[j];
+            b.eps[size_t(j) * n + s]   = m.eps[j];
+        }
+
+        /* 與 arima_forecast() 相同：取最後 max(p+d,1) 筆，逐層差分並記下每層最新值 */
+        work.assign(history.end() - std::max(need, 1), history.end());
+        b.level[s] = work.back();
+        for (int k = 1; k <= m.d; ++k) {
+            for (size_t i = work.size() - 1; i >= 1; --i) work[i] -= work[i - 1];
+            work.erase(work.begin());
+            if (k < m.d) b.level[size_t(k) * n + s] = work.back();
+        }
+        for (int i = 0; i < m.p; ++i)
+            b.lag[size_t(i) * n + s] = work[work.size() - 1 - i];
+    }
+    return true;
+}
+
+// Δ^d 層級的一步預測 dhat[s] = μ + φ·lag + θ·ε；ar / ma 為暫存 (長度 n)
+inline void arima_batch_predict(const ArimaBatch& b, double* dhat, double* ar, double* ma) {
+    const int n = b.n;
+    /* AR / MA 點積：外層係數、內層序列 → 連續記憶體、可向量化 */
+    std::fill_n(ar, n, 0.0);
+    for (int i = 0; i < b.p; ++i) {
+        const double* ph = &b.phi[size_t(i) * n];
+        const double* lg = &b.lag[size_t((b.lag_head + i) % b.p) * n];
+        for (int s = 0; s < n; ++s) ar[s] += ph[s] * lg[s];
+    }
+    std::fill_n(ma, n, 0.0);
+    for (int j = 0; j < b.q; ++j) {
+        const double* th = &b.theta[size_t(j) * n];
+        const double* ep = &b.eps[size_t((b.eps_head + j) % b.q) * n];
+        for (int s = 0; s < n; ++s) ma[s] += th[s] * ep[s];
+    }
+    for (int s = 0; s < n; ++s) dhat[s] = b.mu[s] + ar[s] + ma[s];
+}
+
+/* out: [n_steps][n] 逐步、逐序列；每條序列的運算順序與 arima_forecast() 相同。
+ * ar / ma / carry 為呼叫端的暫存 (長度 n)，重複呼叫 (--stream 每個 tick) 不配置記憶體 */
+inline void arima_forecast_batch(ArimaBatch& b, int n_steps, double* out, double* ar, double* ma, double* carry) {
+    const int n = b.n;
+    for (int step = 0; step < n_steps; ++step) {
+        arima_batch_predict(b, carry, ar, ma);                           // carry = Δ^d ŷ
+
+        /* 逐層積分回原始尺度；d = 0 時同樣加上最新值 (同 arima_forecast) */
+        double* y = &out[size_t(step) * n];
+        if (b.p > 0) b.lag_head = (b.lag_head + b.p - 1) % b.p;
+        double* new_lag = b.p > 0 ? &b.lag[size_t(b.lag_head) * n] : nullptr;
+        for (int s = 0; s < n; ++s) if (new_lag && b.d[s] > 0) new_lag[s] = carry[s];
+        for (int k = b.lv - 1; k >= 0; --k) {
+            double* lvl = &b.level[size_t(k) * n];
+            for (int s = 0; s < n; ++s) {
+                if (k < std::max(b.d[s], 1)) {
+                    lvl[s] += carry[s];
+                    carry[s] = lvl[s];
+                }
+            }
+        }
+        for (int s = 0; s < n; ++s) {
+            y[s] = carry[s];
+            if (new_lag && b.d[s] == 0) new_lag[s] = carry[s];
+        }
+
+        /* ε_{t+1} 期望 0 → 入首 */
+        if (b.q > 0) {
+            b.eps_head = (b.eps_head + b.q - 1) % b.q;
+            std::fill_n(&b.eps[size_t(b.eps_head) * n], n, 0.0);
+        }
+    }
+}
+
+inline void arima_forecast_batch(ArimaBatch& b, int n_steps, std::vector<double>& out) {
+    out.resize(size_t(n_steps) * b.n);
+    std::vector<double> ar(b.n), ma(b.n), carry(b.n);
+    arima_forecast_batch(b, n_steps, out.data(), ar.data(), ma.data(), carry.data());
+}
+
+/* 收到真實觀測 y_obs[s] (每條序列一個)：先算這一步的預測，
+ * 殘差 ε_t = y - ŷ 推入 MA 環，差分狀態往前推一格。
+ * 成本 O(p + q + d)，與歷史長度無關 (同 statsmodels append(refit=False))。
+ * resid 非空時另外寫出各序列的一步殘差 */
+inline void arima_batch_observe(ArimaBatch& b, const double* y_obs,
+                         double* dhat, double* ar, double* ma, double* resid_out = nullptr) {
+    const int n = b.n;
+    arima_batch_predict(b, dhat, ar, ma);
+
+    if (b.p > 0) b.lag_head = (b.lag_head + b.p - 1) % b.p;
+    if (b.q > 0) b.eps_head = (b.eps_head + b.q - 1) % b.q;
+    double* new_lag = b.p > 0 ? &b.lag[size_t(b.lag_head) * n] : nullptr;
+    double* new_eps = b.q > 0 ? &b.eps[size_t(b.eps_head) * n] : nullptr;
+
+    for (int s = 0; s < n; ++s) {
+        double resid;
+        if (b.d[s] == 0) {                         // ŷ = 最新值 + dhat
+            resid = y_obs[s] - (b.level[s] + dhat[s]);
+            b.level[s] = y_obs[s];
+            if (new_lag) new_lag[s] = y_obs[s];
+        } else {                                   // 逐層差分：Δ^{k+1}y = Δ^k y - 舊 Δ^k y
+            double carry = y_obs[s];
+            for (int k = 0; k < b.d[s]; ++k) {
+                double& lvl = b.level[size_t(k) * n + s];
+                double diff = carry - lvl;
+                lvl = carry;
+                carry = diff;
+            }
+            resid = carry - dhat[s];               // carry = Δ^d y_t
+            if (new_lag) new_lag[s] = carry;
+        }
+        if (new_eps) new_eps[s] = resid;
+        if (resid_out) resid_out[s] = resid;
+    }
+}
+
+//------------------------------------------------------------
+// SIMD lane-per-series 核心：同階數的序列放進同一個暫存器的各 lane，
+// 一次推進 4/8/16 條序列 (W lanes × R 個暫存器)。double 版本與
+// arima_forecast_batch() 逐位元相同 (不使用 FMA、加法順序一致)
+//------------------------------------------------------------
+template <typename T>
+struct ArimaLanes {
+    int n = 0, n_pad = 0;         // 實際 / 補齊到 block 倍數的序列數
+    int p = 0, q = 0, d = 0, lv = 1;
+    int lag_head = 0, eps_head = 0;
+    std::vector<T> mu;            // [n_pad]
+    std::vector<T> phi, lag;      // [p][n_pad]
+    std::vector<T> theta, eps;    // [q][n_pad]
+    std::vector<T> level;         // [lv][n_pad]
+};
+
+// 由 ArimaBatch 轉成 lane 佈局；所有序列 d 必須相同，否則回傳 false 走純量路徑
+template <typename T>
+bool make_arima_lanes(const ArimaBatch& b, int block, ArimaLanes<T>& L) {
+    for (int s = 1; s < b.n; ++s) if (b.d[s] != b.d[0]) return false;
+    L = ArimaLanes<T>{};
+    L.n = b.n;
+    L.n_pad = (b.n + block - 1) / block * block;
+    L.p = b.p; L.q = b.q; L.lv = b.lv;
+    L.d = b.n > 0 ? b.d[0] : 0;
+    L.lag_head = b.lag_head; L.eps_head = b.eps_head;
+
+    auto copy_rows = [&](const std::vector<double>& src, int rows, std::vector<T>& dst) {
+        dst.assign(size_t(rows) * L.n_pad, T(0));     // 補齊的 lane 全為 0，結果捨棄
+        for (int r = 0; r < rows; ++r)
+            for (int s = 0; s < b.n; ++s) dst[size_t(r) * L.n_pad + s] = T(src[size_t(r) * b.n + s]);
+    };
+    copy_rows(b.mu, 1, L.mu);
+    copy_rows(b.phi, L.p, L.phi);
+    copy_rows(b.lag, L.p, L.lag);
+    copy_rows(b.theta, L.q, L.theta);
+    copy_rows(b.eps, L.q, L.eps);
+    copy_rows(b.level, L.lv, L.level);
+    return true;
+}
+
+// 純量後備：與 SIMD 核心同樣的 block 外、步數內迴圈，只是每個 lane 各算一次
+template <typename T>
+void arima_lanes_scalar(ArimaLanes<T>& L, int n_steps, T* out) {
+    const int n = L.n_pad;
+    for (int s = 0; s < n; ++s) {
+        int lag_head = L.lag_head, eps_head = L.eps_head;
+        for (int step = 0; step < n_steps; ++step) {
+            T ar = 0, ma = 0;
+            for (int i = 0; i < L.p; ++i)
+                ar += L.phi[size_t(i) * n + s] * L.lag[size_t((lag_head + i) % L.p) * n + s];
+            for (int j = 0; j < L.q; ++j)
+                ma += L.theta[size_t(j) * n + s] * L.eps[size_t((eps_head + j) % L.q) * n + s];
+            const T dhat = L.mu[s] + ar + ma;
+            T carry = dhat;
+            for (int k = L.lv - 1; k >= 0; --k) {
+                T& lvl = L.level[size_t(k) * n + s];
+                lvl += carry;
+                carry = lvl;
+            }
+            if (L.p > 0) {
+                lag_head = (lag_head + L.p - 1) % L.p;
+                L.lag[size_t(lag_head) * n + s] = L.d > 0 ? dhat : carry;
+            }
+            if (L.q > 0) {
+                eps_head = (eps_head + L.q - 1) % L.q;
+                L.eps[size_t(eps_head) * n + s] = 0;
+            }
+            out[size_t(step) * n + s] = carry;
+        }
+    }
+}
+
+enum class SimdIsa { Scalar, Avx2, Neon };
+
+inline const char* simd_isa_name(SimdIsa isa) {
+    switch (isa) {
+        case SimdIsa::Avx2: return "avx2";
+        case SimdIsa::Neon: return "neon";
+        default:            return "scalar";
+    }
+}
+
+// 執行期偵測：x86 以 cpuid 判斷 AVX2；aarch64 以 HWCAP 判斷 Advanced SIMD
+inline SimdIsa detect_simd_isa() {
+#if defined(__x86_64__) || defined(__i386__)
+    if (__builtin_cpu_supports("avx2")) return SimdIsa::Avx2;
+#elif defined(__aarch64__)
+    if (getauxval(AT_HWCAP) & HWCAP_ASIMD) return SimdIsa::Neon;
+#endif
+    return SimdIsa::Scalar;
+}
+
+/* 各指令集的 lane 操作；只用 add/mul (不合併成 FMA) 以維持與純量路徑相同的捨入。
+ * x86 的 AVX2 程式碼以 target pragma 編譯，基本建置 (-O3 無 -mavx2) 仍可在舊 CPU 上執行 */
+#if defined(__x86_64__) || defined(__i386__)
+#pragma GCC push_options
+#pragma GCC target("avx2")
+struct LaneOpsF64 {
+    using T = double; using V = __m256d;
+    static constexpr int W = 4;
+    static V zero()                 { return _mm256_setzero_pd(); }
+    static V load(const T* p)       { return _mm256_loadu_pd(p); }
+    static void store(T* p, V v)    { _mm256_storeu_pd(p, v); }
+    static V add(V a, V b)          { return _mm256_add_pd(a, b); }
+    static V mul(V a, V b)          { return _mm256_mul_pd(a, b); }
+};
+struct LaneOpsF32 {
+    using T = float; using V = __m256;
+    static constexpr int W = 8;
+    static V zero()                 { return _mm256_setzero_ps(); }
+    static V load(const T* p)       { return _mm256_loadu_ps(p); }
+    static void store(T* p, V v)    { _mm256_storeu_ps(p, v); }
+    static V add(V a, V b)          { return _mm256_add_ps(a, b); }
+    static V mul(V a, V b)          { return _mm256_mul_ps(a, b); }
+};
+#define ARIMA_HAVE_LANE_OPS SimdIsa::Avx2
+#elif defined(__aarch64__)
+struct LaneOpsF64 {
+    using T = double; using V = float64x2_t;
+    static constexpr int W = 2;
+    static V zero()                 { return vdupq_n_f64(0.0); }
+    static V load(const T* p)       { return vld1q_f64(p); }
+    static void store(T* p, V v)    { vst1q_f64(p, v); }
+    static V add(V a, V b)          { return vaddq_f64(a, b); }
+    static V mul(V a, V b)          { return vmulq_f64(a, b); }
+};
+struct LaneOpsF32 {
+    using T = float; using V = float32x4_t;
+    static constexpr int W = 4;
+    static V zero()                 { return vdupq_n_f32(0.0f); }
+    static V load(const T* p)       { return vld1q_f32(p); }
+    static void store(T* p, V v)    { vst1q_f32(p, v); }
+    static V add(V a, V b)          { return vaddq_f32(a, b); }
+    static V mul(V a, V b)          { return vmulq_f32(a, b); }
+};
+#define ARIMA_HAVE_LANE_OPS SimdIsa::Neon
+#endif
+
+#ifdef ARIMA_HAVE_LANE_OPS
+/* 每個 block = R 個暫存器 × W lanes 條序列；block 內所有狀態留在暫存器/L1，
+ * 逐步推進 n_steps 後再換下一個 block。環狀 head 對所有 lane 相同 */
+template <class Ops, int R>
+void arima_lanes_simd(ArimaLanes<typename Ops::T>& L, int n_steps, typename Ops::T* out) {
+    using T = typename Ops::T;
+    using V = typename Ops::V;
+    constexpr int W = Ops::W;
+    const int n = L.n_pad, p = L.p, q = L.q;
+
+    for (int o = 0; o < n; o += W * R) {
+        int lag_head = L.lag_head, eps_head = L.eps_head;
+        for (int step = 0; step < n_steps; ++step) {
+            V ar[R], ma[R], dhat[R], carry[R];
+            for (int r = 0; r < R; ++r) ar[r] = ma[r] = Ops::zero();
+            for (int i = 0; i < p; ++i) {
+                const T* ph = &L.phi[size_t(i) * n + o];
+                const T* lg = &L.lag[size_t((lag_head + i) % p) * n + o];
+                for (int r = 0; r < R; ++r)
+                    ar[r] = Ops::add(ar[r], Ops::mul(Ops::load(ph + r * W), Ops::load(lg + r * W)));
+            }
+            for (int j = 0; j < q; ++j) {
+                const T* th = &L.theta[size_t(j) * n + o];
+                const T* ep = &L.eps[size_t((eps_head + j) % q) * n + o];
+                for (int r = 0; r < R; ++r)
+                    ma[r] = Ops::add(ma[r], Ops::mul(Ops::load(th + r * W), Ops::load(ep + r * W)));
+            }
+            for (int r = 0; r < R; ++r)
+                carry[r] = dhat[r] = Ops::add(Ops::add(Ops::load(&L.mu[o + r * W]), ar[r]), ma[r]);
+
+            for (int k = L.lv - 1; k >= 0; --k) {
+                T* lvl = &L.level[size_t(k) * n + o];
+                for (int r = 0; r < R; ++r) {
+                    carry[r] = Ops::add(Ops::load(lvl + r * W), carry[r]);
+                    Ops::store(lvl + r * W, carry[r]);
+                }
+            }
+            if (p > 0) {
+                lag_head = (lag_head + p - 1) % p;
+                T* nl = &L.lag[size_t(lag_head) * n + o];
+                for (int r = 0; r < R; ++r) Ops::store(nl + r * W, L.d > 0 ? dhat[r] : carry[r]);
+            }
+            if (q > 0) {
+                eps_head = (eps_head + q - 1) % q;
+                T* ne = &L.eps[size_t(eps_head) * n + o];
+                for (int r = 0; r < R; ++r) Ops::store(ne + r * W, Ops::zero());
+            }
+            T* y = out + size_t(step) * n + o;
+            for (int r = 0; r < R; ++r) Ops::store(y + r * W, carry[r]);
+        }
+    }
+}
+
+template <class Ops>
+void arima_lanes_simd_block(ArimaLanes<typename Ops::T>& L, int block, int n_steps, typename Ops::T* out) {
+    switch (block / Ops::W) {
+        case 1:  arima_lanes_simd<Ops, 1>(L, n_steps, out); break;
+        case 2:  arima_lanes_simd<Ops, 2>(L, n_steps, out); break;
+        case 4:  arima_lanes_simd<Ops, 4>(L, n_steps, out); break;
+        default: arima_lanes_simd<Ops, 8>(L, n_steps, out); break;
+    }
+}
+#endif
+#if defined(__x86_64__) || defined(__i386__)
+#pragma GCC pop_options
+#endif
+
+/* 以 SIMD lane 核心預測整批序列，輸出佈局同 arima_forecast_batch() ([step][series])，
+ * out 長度須 ≥ n_steps × b.n。
+ * lanes = 每個 block 的序列數 (4/8/16，不足一個暫存器寬度時取暫存器寬度)；
+ * use_float = true 時以 float 計算 (每個暫存器 lane 數加倍)。實際使用的 block 寫回 block。
+ * 序列 d 不一致時回傳 false，由呼叫端改用 arima_forecast_batch() */
+template <typename T>
+bool arima_forecast_lanes_t(const ArimaBatch& b, int lanes, int n_steps,
+                            Span<double> out, SimdIsa& isa, int& block) {
+    isa = detect_simd_isa();
+#ifdef ARIMA_HAVE_LANE_OPS
+    using Ops = std::conditional_t<std::is_same<T, double>::value, LaneOpsF64, LaneOpsF32>;
+    block = isa == SimdIsa::Scalar ? lanes : std::max(lanes, Ops::W);
+#else
+    block = lanes;
+#endif
+    ArimaLanes<T> L;
+    if (!make_arima_lanes(b, block, L)) return false;
+
+    std::vector<T> y(size_t(n_steps) * L.n_pad);
+#ifdef ARIMA_HAVE_LANE_OPS
+    if (isa != SimdIsa::Scalar) arima_lanes_simd_block<Ops>(L, block, n_steps, y.data());
+    else
+#endif
+    arima_lanes_scalar(L, n_steps, y.data());
+
+    for (int step = 0; step < n_steps; ++step)
+        for (int s = 0; s < b.n; ++s) out[size_t(step) * b.n + s] = double(y[size_t(step) * L.n_pad + s]);
+    return true;
+}
+
+inline bool arima_forecast_lanes(const ArimaBatch& b, int lanes, bool use_float, int n_steps,
+                                 Span<double> out, SimdIsa& isa, int& block) {
+    return use_float ? arima_forecast_lanes_t<float>(b, lanes, n_steps, out, isa, block)
+                     : arima_forecast_lanes_t<double>(b, lanes, n_steps, out, isa, block);
+}
@@ -0,0 +1,385 @@
+#pragma once
+//------------------------------------------------------------
+// 裝置端估計 (header-only)：可累加的自我共變異數 AcovAccumulator、Hannan–Rissanen
+// 兩階段估計 (hr_estimate / arima_refit)，以及在 (p,d,q) 格點上平行擬合、
+// 依 AIC / BIC 計分的階數搜尋 arima_order_search()
+//------------------------------------------------------------
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "arima.h"
+#include "linalg.h"
+
+//------------------------------------------------------------
+// 裝置端重新估計 (Hannan–Rissanen) ‒ 只靠自我共變異數
+// 第一階段：長 AR(m) 以 Levinson–Durbin 解 Yule–Walker；
+// 第二階段：x_t 對 [x 落後, ε 落後] 迴歸，ε 是 x 的線性組合，
+// 所以正規方程的每一項都能由 γ(0..m+max(p,q)) 算出，不需再掃過資料。
+// γ 由可累加的交叉乘積和維護，新資料進來只需 O(新點數 × 落後數)。
+//------------------------------------------------------------
+class AcovAccumulator {
+public:
+    int  d = 0, L = 0, W = 0;                      // 差分階、最大落後、保留尾端長度 (≥ L+1)
+    long n = 0, n_raw = 0;                         // 已累積的差分點數 / 原始點數
+
+    void reset(int d_, int max_lag, int tail_len) {
+        d = d_; L = max_lag; W = std::max(tail_len, max_lag + 1);
+        n = n_raw = 0;
+        sum = 0.0;
+        S.assign(L + 1, 0.0);
+        head.assign(L, 0.0);
+        tail.assign(W, 0.0);
+        tail_pos = 0;
+        lvl.assign(d, 0.0);
+    }
+
+    // 原始尺度新觀測：先在線差分，再更新 S_k = Σ x_t x_{t-k}
+    void push(double y) {
+        double carry = y;
+        const int k_max = int(std::min<long>(n_raw, d));
+        for (int k = 0; k < k_max; ++k) {
+            const double diff = carry - lvl[k];
+            lvl[k] = carry;
+            carry = diff;
+        }
+        if (n_raw < d) { lvl[n_raw++] = carry; return; }
+        ++n_raw;
+
+        const double x = carry;
+        const int lags = int(std::min<long>(n, L));
+        for (int k = 1; k <= lags; ++k) S[k] += x * back(k - 1);
+        S[0] += x * x;
+        sum  += x;
+        if (n < L) head[n] = x;
+        tail[tail_pos] = x;
+        tail_pos = (tail_pos + 1) % W;
+        ++n;
+    }
+
+    // x_{n-1-k}：k = 0 為最新
+    double back(int k) const { return tail[(tail_pos - 1 - k + 2 * W) % W]; }
+
+    // γ(k), k = 0..L；center 時扣掉樣本平均 (邊界項以 head / tail 精確修正)，除以 n (偏估計，保證正定)
+    bool autocov(bool center, std::vector<double>& gamma, double& mean) const {
+        if (n <= L) { std::cerr << "Error: need more than " << L << " differenced points to refit\n"; return false; }
+        mean = center ? sum / double(n) : 0.0;
+        gamma.assign(L + 1, 0.0);
+        double first = 0.0, last = 0.0;            // 前 k / 後 k 個點的和
+        for (int k = 0; k <= L; ++k) {
+            if (k > 0) { first += head[k - 1]; last += back(k - 1); }
+            const double c = S[k] - mean * ((sum - first) + (sum - last)) + double(n - k) * mean * mean;
+            gamma[k] = c / double(n);
+        }
+        return true;
+    }
+
+    // 最近 min(n, W) 個差分值，由舊到新
+    std::vector<double> recent() const {
+        const int len = int(std::min<long>(n, W));
+        std::vector<double> out(len);
+        for (int i = 0; i < len; ++i) out[i] = back(len - 1 - i);
+        return out;
+    }
+
+    // 累積狀態存檔：header + S / head / tail(由舊到新) / lvl
+    bool save(const std::string& filename) const {
+        std::ofstream f(filename, std::ios::binary);
+        if (!f.is_open()) { std::cerr << "Cannot write state: " << filename << '\n'; return false; }
+        const int32_t hdr[4] = {kVersion, d, L, W};
+        f.write("ACOV", 4);
+        f.write(reinterpret_cast<const char*>(hdr), sizeof(hdr));
+        f.write(reinterpret_cast<const char*>(&n), sizeof(n));
+        f.write(reinterpret_cast<const char*>(&n_raw), sizeof(n_raw));
+        f.write(reinterpret_cast<const char*>(&sum), sizeof(sum));
+        const std::vector<double> r = recent();
+        std::vector<double> t(W, 0.0);
+        std::copy(r.begin(), r.end(), t.begin());
+        const std::vector<double>* parts[] = {&S, &head, &t, &lvl};
+        for (const auto* v : parts)
+            f.write(reinterpret_cast<const char*>(v->data()), sizeof(double) * v->size());
+        return bool(f);
+    }
+
+    /* 讀回存檔。header 的 d / L / W 先驗證再配置：d 須等於 want_d，
+     * min_lag ≤ L ≤ kMaxLag，L + 1 ≤ W ≤ kMaxTail，檔案大小須與 header 相符；
+     * tail_len > 0 時 W 須與其相同 (0 = 沿用存檔的 W) */
+    bool load(const std::string& filename, int want_d, int min_lag, int tail_len) {
+        std::ifstream f(filename, std::ios::binary | std::ios::ate);
+        if (!f.is_open()) { std::cerr << "Cannot open state: " << filename << '\n'; return false; }
+        const std::streamoff file_bytes = f.tellg();
+        f.seekg(0);
+        char magic[4];
+        int32_t hdr[4];
+        f.read(magic, 4);
+        f.read(reinterpret_cast<char*>(hdr), sizeof(hdr));
+        if (!f || !std::equal(magic, magic + 4, "ACOV") || hdr[0] != kVersion) {
+            std::cerr << "Error: " << filename << " is not an autocovariance state v" << kVersion << '\n';
+            return false;
+        }
+        const int sd = hdr[1], sL = hdr[2], sW = hdr[3];
+        if (sd != want_d) { std::cerr << "Error: state was built for d=" << sd << ", model has d=" << want_d << '\n'; return false; }
+        if (sL < min_lag || sL > kMaxLag) {
+            std::cerr << "Error: state keeps lags up to " << sL << ", order needs " << min_lag << " (at most " << kMaxLag << ")\n";
+            return false;
+        }
+        if (sW < sL + 1 || sW > kMaxTail) {
+            std::cerr << "Error: state keeps " << sW << " tail points, must be " << sL + 1 << ".." << kMaxTail << '\n';
+            return false;
+        }
+        if (tail_len > 0 && sW != std::max(tail_len, sL + 1)) {
+            std::cerr << "Error: state keeps a tail of " << sW << " points, " << tail_len << " were requested\n";
+            return false;
+        }
+        const std::streamoff want_bytes = 4 + std::streamoff(sizeof(hdr)) + 2 * std::streamoff(sizeof(long)) + 8
+                                        + 8 * (std::streamoff(sL) + 1 + sL + sW + sd);
+        if (file_bytes != want_bytes) {
+            std::cerr << "Error: " << filename << " has " << file_bytes << " bytes, header implies " << want_bytes << '\n';
+            return false;
+        }
+        reset(sd, sL, sW);
+        f.read(reinterpret_cast<char*>(&n), sizeof(n));
+        f.read(reinterpret_cast<char*>(&n_raw), sizeof(n_raw));
+        f.read(reinterpret_cast<char*>(&sum), sizeof(sum));
+        for (auto* v : {&S, &head, &tail, &lvl})
+            f.read(reinterpret_cast<char*>(v->data()), sizeof(double) * v->size());
+        if (!f) { std::cerr << "Error: truncated state " << filename << '\n'; return false; }
+        if (n < 0 || n_raw < n || n_raw - n > d) { std::cerr << "Error: inconsistent counts in " << filename << '\n'; return false; }
+        tail_pos = int(std::min<long>(n, W)) % W;
+        return true;
+    }
+
+    static constexpr int kDefaultTail = 500;       // 預設保留的差分尾端 (重建最新 q 個殘差用)
+    static constexpr int kMaxLag  = 1 << 12;
+    static constexpr int kMaxTail = 1 << 20;
+
+private:
+    static constexpr int32_t kVersion = 1;
+    double sum = 0.0;
+    std::vector<double> S, head, tail, lvl;        // tail 為長度 W 的環
+    int tail_pos = 0;
+};
+
+// 長 AR 階數 m；第二階段需要 γ 到 m + max(p, q)
+inline int hr_long_order(int p, int q) { return q > 0 ? std::max(20, 2 * (p + q)) : 0; }
+
+// Levinson–Durbin：γ(0..m) → AR(m) 係數 a[1..m] (a[0] 不用)
+inline bool levinson_durbin(const std::vector<double>& g, int m, std::vector<double>& a) {
+    a.assign(m + 1, 0.0);
+    std::vector<double> prev(m + 1, 0.0);
+    double err = g[0];
+    for (int k = 1; k <= m; ++k) {
+        if (err <= 0.0) return false;
+        double acc = g[k];
+        for (int j = 1; j < k; ++j) acc -= prev[j] * g[k - j];
+        const double refl = acc / err;
+        a[k] = refl;
+        for (int j = 1; j < k; ++j) a[j] = prev[j] - refl * prev[k - j];
+        err *= (1.0 - refl * refl);
+        prev = a;
+    }
+    return true;
+}
+
+/* Hannan–Rissanen 兩階段，只用 γ(0..m+max(p,q))：填入 p/d/q、phi、theta、sigma2 (eps 留給呼叫端)。
+ * 同訓練腳本 (d ≥ 1) 不含常數項，mu = 0。g 可由多個候選階數共用 */
+inline bool hr_estimate(const std::vector<double>& g, int d, int p, int q, ArimaParams& out) {
+    const int m = hr_long_order(p, q);
+    if (int(g.size()) <= m + std::max(p, q)) {
+        std::cerr << "Error: autocovariances up to lag " << g.size() - 1 << ", order needs " << m + std::max(p, q) << '\n';
+        return false;
+    }
+    auto gam = [&](int k) { return g[std::abs(k)]; };
+
+    /* 第一階段：ε_t = Σ_l c_l x_{t-l}，c_0 = 1、c_l = -a_l */
+    std::vector<double> c(m + 1, 0.0);
+    c[0] = 1.0;
+    if (m > 0) {
+        std::vector<double> a;
+        if (!levinson_durbin(g, m, a)) { std::cerr << "Error: long AR fit failed\n"; return false; }
+        for (int l = 1; l <= m; ++l) c[l] = -a[l];
+    }
+    auto x_eps = [&](int lag) {                    // E[x_t ε_{t-lag}]
+        double s = 0.0;
+        for (int l = 0; l <= m; ++l) s += c[l] * gam(lag + l);
+        return s;
+    };
+    auto eps_eps = [&](int lag) {                  // E[ε_t ε_{t-lag}]
+        double s = 0.0;
+        for (int l = 0; l <= m; ++l)
+            for (int l2 = 0; l2 <= m; ++l2) s += c[l] * c[l2] * gam(lag + l2 - l);
+        return s;
+    };
+
+    /* 第二階段正規方程：未知數 [φ_1..φ_p, θ_1..θ_q] */
+    const int k = p + q;
+    std::vector<double> A(size_t(k) * k), b(k);
+    for (int r = 0; r < k; ++r) {
+        for (int col = 0; col < k; ++col) {
+            double v;
+            if (r < p && col < p)       v = gam(r - col);
+            else if (r < p)             v = x_eps((col - p) - r);      // E[x_{t-1-r} ε_{t-1-j}]
+            else if (col < p)           v = x_eps((r - p) - col);
+            else                        v = eps_eps((r - p) - (col - p));
+            A[size_t(r) * k + col] = v;
+        }
+        b[r] = (r < p) ? gam(r + 1) : x_eps(r - p + 1);
+    }
+    std::vector<double> beta = b;
+    if (k > 0 && !solve_linear(A, beta, k)) { std::cerr << "Error: singular Hannan–Rissanen system\n"; return false; }
+
+    out = ArimaParams{};
+    out.p = p; out.d = d; out.q = q;
+    out.phi.assign(beta.begin(), beta.begin() + p);
+    out.theta.assign(beta.begin() + p, beta.end());
+    double explained = 0.0;
+    for (int i = 0; i < k; ++i) explained += beta[i] * b[i];
+    out.sigma2 = std::max(gam(0) - explained, 0.0);
+    return true;
+}
+
+/* 由累積的自我共變異數估計 ARIMA(p, acc.d, q)，同訓練腳本不含常數項。
+ * 只接受 d ≥ 1：d = 0 時 arima_forecast() 把 ARMA 值加在最後一筆觀測上，標準 ARMA 的估計值寫出後會發散 */
+inline bool arima_refit(const AcovAccumulator& acc, int p, int q, ArimaParams& out) {
+    if (acc.d < 1) { std::cerr << "Error: refit needs d ≥ 1\n"; return false; }
+    const int m = hr_long_order(p, q);
+    if (acc.L < m + std::max(p, q)) {
+        std::cerr << "Error: state keeps lags up to " << acc.L << ", order needs " << m + std::max(p, q) << '\n';
+        return false;
+    }
+    std::vector<double> g;
+    double mean = 0.0;
+    if (!acc.autocov(false, g, mean)) return false;
+    if (!hr_estimate(g, acc.d, p, q, out)) return false;
+
+    /* 最新 q 個殘差：在保留的尾端以擬合模型遞迴 (起點殘差設 0) */
+    const std::vector<double> x = acc.recent();
+    std::vector<double> e(x.size(), 0.0);
+    for (size_t t = size_t(p); t < x.size(); ++t) {
+        double v = x[t] - out.mu;
+        for (int i = 0; i < p; ++i) v -= out.phi[i] * x[t - 1 - i];
+        for (int j = 0; j < q && size_t(j) + 1 <= t; ++j) v -= out.theta[j] * e[t - 1 - j];
+        e[t] = v;
+    }
+    out.eps.assign(q, 0.0);
+    for (int j = 0; j < q && size_t(j) < e.size(); ++j) out.eps[j] = e[e.size() - 1 - j];
+    return true;
+}
+
+//------------------------------------------------------------
+// 階數搜尋 ‒ 在 p∈[0,P]、d∈[1,D]、q∈[0,Q] 的格點上以 Hannan–Rissanen 擬合，依 AIC / BIC 挑選。
+// 每個 d 的差分序列與 γ(0..L) 只算一次，由該 d 的所有候選共用；候選由執行緒池平行擬合。
+// 分數為條件平方和 (CSS) 的高斯概似，所有候選都在同一段 y[D+P..n) 上計分：
+// 差分尺度上的一步殘差就是原始尺度上的一步殘差，因此不同 d 之間可以比較。
+// 不含 d = 0：arima_forecast() 在 d = 0 時把 ARMA 值加在最後一筆觀測上 (ŷ = y_{t-1} + μ + Σφy + Σθε)，
+// 標準 ARMA 的估計值寫出後會發散
+//------------------------------------------------------------
+struct OrderLevel {
+    std::vector<double> x;           // Δ^d y，x[t] 對應 y[t + d]
+    std::vector<double> gamma;       // γ(0..L)，不扣平均 (同訓練腳本不含常數項)
+    bool ok = false;
+};
+
+struct OrderCandidate {
+    int p = 0, d = 0, q = 0;
+    bool ok = false;
+    double sigma2 = 0.0, aic = 0.0, bic = 0.0;
+    ArimaParams fit;
+};
+
+// n_threads 個執行緒以原子計數領取 task(0..n_tasks-1)；各任務耗時不一時比固定切段平均
+inline void parallel_for(int n_tasks, int n_threads, const std::function<void(int)>& task) {
+    std::atomic<int> next{0};
+    std::vector<std::thread> pool;
+    for (int k = 0; k < n_threads; ++k)
+        pool.emplace_back([&] { for (int i; (i = next++) < n_tasks;) task(i); });
+    for (auto& th : pool) th.join();
+}
+
+/* 差分序列 x 上的一步殘差 e[t]：遞迴自 t = p 起，e[0..p) 設 0 */
+inline void css_residuals(Span<const double> x, const ArimaParams& fit, std::vector<double>& e) {
+    const int p = fit.p, q = fit.q;
+    e.assign(x.size(), 0.0);
+    for (long t = p; t < long(x.size()); ++t) {
+        double v = x[t] - fit.mu;
+        for (int i = 0; i < p; ++i) v -= fit.phi[i] * x[t - 1 - i];
+        for (int j = 0; j < q && t - 1 - j >= 0; ++j) v -= fit.theta[j] * e[t - 1 - j];
+        e[t] = v;
+    }
+}
+
+/* 擬合一個候選並在 x[start - d..) 上算 CSS；最後 q 個殘差即模型的 eps */
+inline void score_order(const OrderLevel& lv, long start, OrderCandidate& c) {
+    const int p = c.p, d = c.d, q = c.q;
+    if (!hr_estimate(lv.gamma, d, p, q, c.fit)) return;
+    const std::vector<double>& x = lv.x;
+    std::vector<double> e;
+    css_residuals(x, c.fit, e);
+    const long first = start - d;
+    double sse = 0.0;
+    for (long t = first; t < long(x.size()); ++t) sse += e[t] * e[t];
+    const double n_eff = double(long(x.size()) - first);
+    c.sigma2 = sse / n_eff;
+    if (!std::isfinite(c.sigma2) || c.sigma2 <= 0.0) return;
+    const double k = p + q + 1;                     // 係數 + σ² (d ≥ 1 不含常數項)
+    constexpr double kPi = 3.14159265358979323846;
+    const double nll2 = n_eff * (std::log(2.0 * kPi * c.sigma2) + 1.0);
+    c.aic = nll2 + 2.0 * k;
+    c.bic = nll2 + k * std::log(n_eff);
+    c.fit.sigma2 = c.sigma2;
+    c.fit.eps.assign(q, 0.0);
+    for (int j = 0; j < q; ++j) c.fit.eps[j] = e[x.size() - 1 - j];
+    c.ok = true;
+}
+
+/* 格點搜尋：max order = (P, D, Q)，D ≥ 1。levels[d] (d = 1..D) 為共用的差分序列與 γ(0..L)，
+ * cands 依 d、p、q 排列，擬合失敗的候選 ok = false；所有候選都在 y[D+P..n) 上計分。
+ * n_threads 個執行緒 (≥ 1) 平行擬合；排序與挑選留給呼叫端 */
+inline bool arima_order_search(Span<const double> y, int P, int D, int Q, int n_threads,
+                               std::vector<OrderLevel>& levels, std::vector<OrderCandidate>& cands) {
+    if (P < 0 || D < 1 || Q < 0) { std::cerr << "Error: order search needs P, Q ≥ 0 and D ≥ 1\n"; return false; }
+    const int L = hr_long_order(P, Q) + std::max(P, Q);   // 格點內最大的 m + max(p, q)
+    const long start = D + P;
+    if (long(y.size()) <= start + L + 1) {
+        std::cerr << "Error: " << y.size() << " points are too short for max order " << P << "," << D << "," << Q << '\n';
+        return false;
+    }
+    n_threads = std::max(n_threads, 1);
+
+    /* 共用資料：各 d 的差分序列 (逐層差分) 與自我共變異數 */
+    levels.assign(D + 1, OrderLevel{});
+    levels[0].x.assign(y.begin(), y.end());
+    for (int d = 1; d <= D; ++d) {
+        const auto& prev = levels[d - 1].x;
+        levels[d].x.resize(prev.size() - 1);
+        for (size_t t = 1; t < prev.size(); ++t) levels[d].x[t - 1] = prev[t] - prev[t - 1];
+    }
+    parallel_for(D, std::min(n_threads, D), [&](int i) {
+        const int d = i + 1;
+        AcovAccumulator acc;
+        acc.reset(0, L, L + 1);
+        for (double v : levels[d].x) acc.push(v);
+        double mean = 0.0;
+        levels[d].ok = acc.autocov(false, levels[d].gamma, mean);
+    });
+
+    cands.clear();
+    for (int d = 1; d <= D; ++d)
+        for (int p = 0; p <= P; ++p)
+            for (int q = 0; q <= Q; ++q) {
+                OrderCandidate c;
+                c.p = p; c.d = d; c.q = q;
+                cands.push_back(c);
+            }
+    parallel_for(int(cands.size()), n_threads, [&](int i) {
+        if (levels[cands[i].d].ok) score_order(levels[cands[i].d], start, cands[i]);
+    });
+    return true;
+}
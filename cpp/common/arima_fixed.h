@@ -0,0 +1,102 @@
+#pragma once
+//------------------------------------------------------------
+// 固定階數 ARIMA 核心 (header-only)：部署中常見的 (p,d,q) 以模板展開，
+// arima_forecast_dispatch() 依模型階數挑選，沒有對應時退回 ArimaForecaster。
+// 歷史與輸出皆為呼叫端緩衝，out.size() 即預測步數
+//------------------------------------------------------------
+#include <algorithm>
+#include <array>
+#include <iostream>
+
+#include "arima.h"
+
+//------------------------------------------------------------
+// 固定 (p,d,q) 特化核心 ‒ 階數為編譯期常數，點積 / 積分完全展開，
+// 狀態放在 std::array 區域變數 (暫存器)；運算順序與 arima_forecast() 相同
+//------------------------------------------------------------
+template <int P, int D, int Q>
+bool arima_forecast_fixed(const ArimaModelView& m, Span<const double> history, Span<double> out) {
+    constexpr int need = P + D;
+    constexpr int W    = need > 0 ? need : 1;
+    constexpr int LV   = D > 0 ? D : 1;
+    if (int(history.size()) < W) {
+        std::cerr << "Error: history length < p + d = " << need << '\n';
+        return false;
+    }
+
+    std::array<double, P> phi{}, lag{};            // lag[i] = 第 i 個落後 Δ^d y
+    std::array<double, Q> theta{}, eps{};
+    std::array<double, LV> lvl{};                  // lvl[k] = 最新 Δ^k y
+    for (int i = 0; i < P; ++i) phi[i] = m.phi[i];
+    for (int j = 0; j < Q; ++j) { theta[j] = m.theta[j]; eps[j] = m.eps[j]; }
+    const double mu = m.mu;
+
+    std::array<double, W> work{};
+    std::copy(history.end() - W, history.end(), work.begin());
+    lvl[0] = work[W - 1];
+    for (int k = 1; k <= D; ++k) {                 // 第 k 次差分後有效區段為 work[k..W-1]
+        for (int i = W - 1; i >= k; --i) work[i] -= work[i - 1];
+        if (k < D) lvl[k] = work[W - 1];
+    }
+    for (int i = 0; i < P; ++i) lag[i] = work[W - 1 - i];
+
+    const int n_steps = int(out.size());
+    for (int step = 0; step < n_steps; ++step) {
+        double ar_sum = 0.0;
+        for (int i = 0; i < P; ++i) ar_sum += phi[i] * lag[i];
+        double ma_sum = 0.0;
+        for (int j = 0; j < Q; ++j) ma_sum += theta[j] * eps[j];
+        const double diff_d_hat = mu + ar_sum + ma_sum;
+
+        double carry = diff_d_hat;
+        for (int k = LV - 1; k >= 0; --k) {
+            lvl[k] += carry;
+            carry = lvl[k];
+        }
+
+        if constexpr (P > 0) {
+            for (int i = P - 1; i >= 1; --i) lag[i] = lag[i - 1];
+            lag[0] = (D == 0) ? carry : diff_d_hat;
+        }
+        if constexpr (Q > 0) {
+            for (int j = Q - 1; j >= 1; --j) eps[j] = eps[j - 1];
+            eps[0] = 0.0;
+        }
+        out[step] = carry;
+    }
+    return true;
+}
+
+using ArimaKernel = bool (*)(const ArimaModelView&, Span<const double>, Span<double>);
+
+struct ArimaKernelEntry { int p, d, q; ArimaKernel fn; };
+
+// 部署中的階數 (p5d2q2、p5d1q0) 加上常見的小階數；新增階數只需加一行
+inline const ArimaKernelEntry kArimaKernels[] = {
+    {5, 2, 2, arima_forecast_fixed<5, 2, 2>},
+    {5, 1, 0, arima_forecast_fixed<5, 1, 0>},
+    {5, 1, 1, arima_forecast_fixed<5, 1, 1>},
+    {5, 0, 0, arima_forecast_fixed<5, 0, 0>},
+    {3, 1, 1, arima_forecast_fixed<3, 1, 1>},
+    {2, 1, 2, arima_forecast_fixed<2, 1, 2>},
+    {2, 1, 0, arima_forecast_fixed<2, 1, 0>},
+    {1, 1, 1, arima_forecast_fixed<1, 1, 1>},
+    {1, 1, 0, arima_forecast_fixed<1, 1, 0>},
+    {1, 0, 0, arima_forecast_fixed<1, 0, 0>},
+    {0, 1, 1, arima_forecast_fixed<0, 1, 1>},
+};
+
+inline ArimaKernel find_arima_kernel(int p, int d, int q) {
+    for (const auto& e : kArimaKernels)
+        if (e.p == p && e.d == d && e.q == q) return e.fn;
+    return nullptr;
+}
+
+// 依模型階數選特化核心，沒有對應時走 ArimaForecaster (結果與 arima_forecast() 相同)
+inline bool arima_forecast_dispatch(const ArimaModelView& m, Span<const double> history, Span<double> out) {
+    if (ArimaKernel fn = find_arima_kernel(m.p, m.d, m.q)) return fn(m, history, out);
+    ArimaForecaster f;
+    if (!f.init(m, history)) return false;
+    f.forecast(out);
+    return true;
+}
@@ -0,0 +1,207 @@
+#pragma once
+//------------------------------------------------------------
+// 階層預測與調和 (header-only)：群組定義 Hierarchy (hierarchy_add_group)、
+// 由底層加總群組、OLS / MinT-shrink 調和 (hierarchy_reconcile) 與一致性檢查。
+// 基礎預測由 arima_batch.h 的批次產生，預測緩衝佈局為 [step][node]
+//------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <string>
+#include <vector>
+
+#include "arima.h"
+#include "arima_batch.h"
+#include "linalg.h"
+
+//------------------------------------------------------------
+// 階層預測 ‒ 底層 (各風機) 一次批次預測，群組 (機群、全場) 以加總得到，
+// 並可用 OLS / MinT 調和各層的基礎預測。節點順序：底層 [0, n)，群組 [n, n + k)
+// 依定義順序 (子群組在前)。約束寫成 C ŷ = 0 (每個群組一列)，調和只需解 k×k 系統
+//------------------------------------------------------------
+struct Hierarchy {
+    int n = 0;                                     // 底層序列數
+    std::vector<std::string> names;                // [k] 群組名稱
+    std::vector<std::vector<int>> members;         // [k] 直接成員：< n 為底層，≥ n 為群組 n + g
+    std::vector<std::vector<int>> leaves;          // [k] 展開後的底層序列
+};
+
+/* 加入群組 name：members 為底層序列 (< n) 或先前加入的群組 (n + g)，
+ * 因此子群組須先加入；leaves 由成員展開。成員無效或為空時回傳 false */
+inline bool hierarchy_add_group(Hierarchy& H, const std::string& name, const std::vector<int>& members) {
+    const int known = H.n + int(H.names.size());
+    if (members.empty()) { std::cerr << "Error: group without members: " << name << '\n'; return false; }
+    std::vector<int> leaf;
+    for (int j : members) {
+        if (j < 0 || j >= known) { std::cerr << "Error: group " << name << " has invalid member " << j << '\n'; return false; }
+        if (j < H.n) leaf.push_back(j);
+        else leaf.insert(leaf.end(), H.leaves[j - H.n].begin(), H.leaves[j - H.n].end());
+    }
+    H.names.push_back(name);
+    H.members.push_back(members);
+    H.leaves.push_back(leaf);
+    return true;
+}
+
+// row[0, n) 為底層值；依定義順序填入 row[n + g] = Σ 直接成員 (子群組已先算好)
+inline void hierarchy_sums(const Hierarchy& H, double* row) {
+    for (size_t g = 0; g < H.members.size(); ++g) {
+        double s = 0.0;
+        for (int j : H.members[g]) s += row[j];
+        row[H.n + g] = s;
+    }
+}
+
+// 不一致量 (C u)_g = u[n + g] - Σ_{leaves(g)} u；tmp 長度 n + k
+inline void hierarchy_gap(const Hierarchy& H, const double* u, double* tmp, double* gap) {
+    std::copy_n(u, H.n, tmp);
+    hierarchy_sums(H, tmp);
+    for (size_t g = 0; g < H.names.size(); ++g) gap[g] = u[H.n + g] - tmp[H.n + g];
+}
+
+/* MinT-shrink 權重 (Schäfer–Strimmer，同 R hts 的 shrink.estim)：
+ * W = λ diag(Σ̂) + (1-λ) Σ̂，Σ̂ = X'X / T 為一步殘差的 (未置中) 共變異數。
+ * X 以 [node][t] 存放，λ 的成對統計量沿 t 連續存取；W 不形成 m×m 矩陣，
+ * 乘向量時以 X'(X c) 計算 */
+struct MintWeights {
+    int m = 0, T = 0;
+    double lambda = 1.0;
+    std::vector<double> X;                         // [m][T]
+    std::vector<double> diag;                      // [m] Σ̂_ii
+
+    bool init(std::vector<double> resid, int m_, int T_) {
+        m = m_; T = T_;
+        X = std::move(resid);
+        diag.assign(m, 0.0);
+        std::vector<double> xs(size_t(m) * T), xs2(size_t(m) * T);
+        for (int i = 0; i < m; ++i) {
+            const double* x = &X[size_t(i) * T];
+            double ss = 0.0;
+            for (int t = 0; t < T; ++t) ss += x[t] * x[t];
+            diag[i] = ss / T;
+            if (!(diag[i] > 0.0)) { std::cerr << "Error: node " << i << " has zero in-sample residual variance\n"; return false; }
+            const double inv = 1.0 / std::sqrt(diag[i]);
+            for (int t = 0; t < T; ++t) {
+                xs[size_t(i) * T + t]  = x[t] * inv;
+                xs2[size_t(i) * T + t] = xs[size_t(i) * T + t] * xs[size_t(i) * T + t];
+            }
+        }
+        double sum_v = 0.0, sum_r2 = 0.0;
+        for (int i = 0; i < m; ++i)
+            for (int j = i + 1; j < m; ++j) {
+                const double* a = &xs[size_t(i) * T];
+                const double* b = &xs[size_t(j) * T];
+                const double* a2 = &xs2[size_t(i) * T];
+                const double* b2 = &xs2[size_t(j) * T];
+                double ab = 0.0, ab2 = 0.0;
+                for (int t = 0; t < T; ++t) { ab += a[t] * b[t]; ab2 += a2[t] * b2[t]; }
+                sum_v  += (ab2 - ab * ab / T) / (double(T) * (T - 1));
+                sum_r2 += (ab / T) * (ab / T);
+            }
+        lambda = sum_r2 > 0.0 ? std::clamp(sum_v / sum_r2, 0.0, 1.0) : 1.0;
+        return true;
+    }
+
+    // out = W c；u 為呼叫端提供、長度 T 的暫存
+    void apply(const double* c, double* out, double* u) const {
+        std::fill_n(u, T, 0.0);
+        for (int j = 0; j < m; ++j) {
+            if (c[j] == 0.0) continue;
+            const double* x = &X[size_t(j) * T];
+            for (int t = 0; t < T; ++t) u[t] += x[t] * c[j];
+        }
+        for (int i = 0; i < m; ++i) {
+            const double* x = &X[size_t(i) * T];
+            double s = 0.0;
+            for (int t = 0; t < T; ++t) s += x[t] * u[t];
+            out[i] = lambda * diag[i] * c[i] + (1.0 - lambda) * s / T;
+        }
+    }
+};
+
+/* 在歷史上逐筆 observe 取得每個節點的一步殘差：前 warm = max(p+d,1) 筆為暖機，
+ * 之後每筆一個殘差，X[node][t] (t = 0..T-1)。各節點歷史須等長 */
+inline bool batch_residuals(const std::vector<ArimaModelView>& params, const std::vector<Span<const double>>& histories,
+                            const std::vector<std::string>& names, std::vector<double>& X, int& T) {
+    const int m = int(histories.size());
+    auto par = [&](int s) -> const ArimaModelView& { return params.size() == 1 ? params[0] : params[s]; };
+    int warm = 1;
+    for (int s = 0; s < m; ++s) warm = std::max(warm, par(s).p + par(s).d);
+    const int len = int(histories[0].size());
+    T = len - warm;
+    if (T < 2) { std::cerr << "Error: history too short for in-sample residuals\n"; return false; }
+
+    std::vector<Span<const double>> head(m);
+    for (int s = 0; s < m; ++s) head[s] = Span<const double>(histories[s].data(), size_t(warm));
+    ArimaBatch b;
+    if (!init_arima_batch(params, head, names, b)) return false;
+    X.assign(size_t(m) * T, 0.0);
+    std::vector<double> y(m), dhat(m), ar(m), ma(m), r(m);
+    for (int t = 0; t < T; ++t) {
+        for (int s = 0; s < m; ++s) y[s] = histories[s][warm + t];
+        arima_batch_observe(b, y.data(), dhat.data(), ar.data(), ma.data(), r.data());
+        for (int s = 0; s < m; ++s) X[size_t(s) * T + t] = r[s];
+    }
+    return true;
+}
+
+/* 調和：ỹ = ŷ - W C'(C W C')⁻¹ C ŷ。M = W C' 的第 g 欄為 W 乘上約束向量 c_g
+ * (+1 在群組 g，-1 在其底層)，K = C M 為 k×k；每個預測步只解一次 k×k 系統。
+ * mint 為空時 W = I (OLS)。fc 為 [step][m]，就地調和 */
+inline bool hierarchy_reconcile(const Hierarchy& H, const MintWeights* mint, Span<double> fc) {
+    const int k = int(H.names.size());
+    const int m = H.n + k;
+    const int n_steps = int(fc.size() / size_t(m));
+    std::vector<double> M(size_t(k) * m), c(m), tmp(m), gap(k), u(mint ? mint->T : 0);
+    for (int g = 0; g < k; ++g) {
+        std::fill(c.begin(), c.end(), 0.0);
+        c[H.n + g] = 1.0;
+        for (int leaf : H.leaves[g]) c[leaf] -= 1.0;
+        if (mint) mint->apply(c.data(), &M[size_t(g) * m], u.data());
+        else      std::copy(c.begin(), c.end(), M.begin() + size_t(g) * m);
+    }
+    std::vector<double> K(size_t(k) * k);
+    for (int g = 0; g < k; ++g) {
+        hierarchy_gap(H, &M[size_t(g) * m], tmp.data(), gap.data());
+        for (int r = 0; r < k; ++r) K[size_t(r) * k + g] = gap[r];
+    }
+    // K 與預測步無關：分解一次，每步只做前代/回代
+    std::vector<int> piv(k);
+    if (!lu_factor(K.data(), piv.data(), k)) { std::cerr << "Error: singular reconciliation system\n"; return false; }
+    for (int step = 0; step < n_steps; ++step) {
+        double* y = &fc[size_t(step) * m];
+        hierarchy_gap(H, y, tmp.data(), gap.data());
+        lu_solve(K.data(), piv.data(), gap.data(), k);
+        for (int g = 0; g < k; ++g) {
+            const double* col = &M[size_t(g) * m];
+            for (int i = 0; i < m; ++i) y[i] -= col[i] * gap[g];
+        }
+    }
+    return true;
+}
+
+// 各預測步中最大的 |C ŷ| (群組與其底層加總的差)
+inline double hierarchy_max_gap(const Hierarchy& H, Span<const double> fc) {
+    const int m = H.n + int(H.names.size());
+    const int n_steps = int(fc.size() / size_t(m));
+    std::vector<double> tmp(m), gap(H.names.size());
+    double worst = 0.0;
+    for (int step = 0; step < n_steps; ++step) {
+        hierarchy_gap(H, &fc[size_t(step) * m], tmp.data(), gap.data());
+        for (double v : gap) worst = std::max(worst, std::fabs(v));
+    }
+    return worst;
+}
+
+/* 群組歷史 = 直接成員歷史逐點相加：nodes[0, n) 為底層 (長度相同)，
+ * 依定義順序填入 nodes[n + g]，子群組已先算好 */
+inline void hierarchy_group_histories(const Hierarchy& H, std::vector<std::vector<double>>& nodes) {
+    const size_t len = H.n > 0 ? nodes[0].size() : 0;
+    nodes.resize(H.n + H.names.size());
+    for (size_t g = 0; g < H.names.size(); ++g) {
+        auto& col = nodes[H.n + g];
+        col.assign(len, 0.0);
+        for (int j : H.members[g])
+            for (size_t t = 0; t < len; ++t) col[t] += nodes[j][t];
+    }
+}
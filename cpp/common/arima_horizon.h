@@ -0,0 +1,180 @@
+#pragma once
+//------------------------------------------------------------
+// 長 horizon 與預測區間 (header-only)：伴隨矩陣 (build_companion) 的平方求冪跳躍預測
+// arima_forecast_horizons()，以及由 ψ 權重算出的預測區間 ArimaIntervals。
+// 兩者都依 ArimaModelView / ArimaForecaster 的狀態運算，輸出寫入呼叫端緩衝
+//------------------------------------------------------------
+#include <algorithm>
+#include <cmath>
+#include <iostream>
+#include <vector>
+
+#include "arima.h"
+
+//------------------------------------------------------------
+// 長 horizon 跳躍預測 ‒ 把一步遞迴寫成伴隨矩陣 x_{t+1} = A x_t，
+// 狀態 x = [lag(p), ε(q), level(max(d,1)), 1]；以平方求冪取 A^h，
+// 每個 horizon 成本 O(n² log h)，預先算 A^(2^k) 為 O(n³ log h_max)
+//------------------------------------------------------------
+struct ArimaCompanion {
+    int n = 0, lag0 = 0, eps0 = 0, lvl0 = 0, one = 0;   // 各區段在 x 中的起點
+    int p = 0, q = 0, lv = 1;
+    std::vector<double> A;                               // n × n, row-major
+};
+
+inline ArimaCompanion build_companion(const ArimaModelView& m) {
+    ArimaCompanion c;
+    c.p = m.p; c.q = m.q; c.lv = std::max(m.d, 1);
+    c.lag0 = 0;
+    c.eps0 = c.p;
+    c.lvl0 = c.p + c.q;
+    c.one  = c.lvl0 + c.lv;
+    c.n    = c.one + 1;
+    const int n = c.n;
+    c.A.assign(size_t(n) * n, 0.0);
+    auto row = [&](int r) { return &c.A[size_t(r) * n]; };
+
+    /* Δ^d ŷ = μ + φ·lag + θ·ε */
+    std::vector<double> dhat(n, 0.0);
+    for (int i = 0; i < c.p; ++i) dhat[c.lag0 + i] = m.phi[i];
+    for (int j = 0; j < c.q; ++j) dhat[c.eps0 + j] = m.theta[j];
+    dhat[c.one] = m.mu;
+
+    /* level'[lv-1] = level[lv-1] + Δ^d ŷ；level'[k] = level[k] + level'[k+1] */
+    std::vector<double> carry = dhat;
+    for (int k = c.lv - 1; k >= 0; --k) {
+        double* r = row(c.lvl0 + k);
+        for (int j = 0; j < n; ++j) r[j] = carry[j];
+        r[c.lvl0 + k] += 1.0;
+        carry.assign(r, r + n);
+    }
+    /* lag 右移，新值為 Δ^d ŷ (d = 0 時為 ŷ)；ε 右移補 0；常數項不變 */
+    if (c.p > 0) {
+        const std::vector<double>& head = (m.d == 0) ? carry : dhat;
+        std::copy(head.begin(), head.end(), row(c.lag0));
+        for (int i = 1; i < c.p; ++i) row(c.lag0 + i)[c.lag0 + i - 1] = 1.0;
+    }
+    for (int j = 1; j < c.q; ++j) row(c.eps0 + j)[c.eps0 + j - 1] = 1.0;
+    row(c.one)[c.one] = 1.0;
+    return c;
+}
+
+// 依 ArimaForecaster 目前狀態，一次算出多個 horizon (≥ 1) 的點預測；out 與 horizons 同長度、同順序
+inline void arima_forecast_horizons(const ArimaForecaster& f, Span<const long> horizons, Span<double> out) {
+    const ArimaCompanion c = build_companion(f.model());
+    const int n = c.n;
+    if (horizons.empty()) return;
+
+    std::vector<double> x(n, 0.0), tmp(n);
+    std::copy(f.lags(),   f.lags()   + c.p,  x.begin() + c.lag0);
+    std::copy(f.resids(), f.resids() + c.q,  x.begin() + c.eps0);
+    std::copy(f.levels(), f.levels() + c.lv, x.begin() + c.lvl0);
+    x[c.one] = 1.0;
+
+    /* pow[k] = A^(2^k) */
+    const long h_max = *std::max_element(horizons.begin(), horizons.end());
+    std::vector<std::vector<double>> pow{c.A};
+    while ((2L << (pow.size() - 1)) <= h_max) {
+        const auto& a = pow.back();
+        std::vector<double> sq(size_t(n) * n, 0.0);
+        for (int i = 0; i < n; ++i)
+            for (int k = 0; k < n; ++k) {
+                const double aik = a[size_t(i) * n + k];
+                if (aik == 0.0) continue;
+                for (int j = 0; j < n; ++j) sq[size_t(i) * n + j] += aik * a[size_t(k) * n + j];
+            }
+        pow.push_back(std::move(sq));
+    }
+
+    /* 依 horizon 由小到大，只前進差值 Δh：x ← A^Δh x */
+    std::vector<size_t> order(horizons.size());
+    for (size_t i = 0; i < order.size(); ++i) order[i] = i;
+    std::sort(order.begin(), order.end(), [&](size_t a, size_t b) { return horizons[a] < horizons[b]; });
+    long at = 0;
+    for (size_t idx : order) {
+        for (long delta = horizons[idx] - at, k = 0; delta > 0; delta >>= 1, ++k) {
+            if (!(delta & 1)) continue;
+            const auto& a = pow[k];
+            for (int i = 0; i < n; ++i) {
+                double acc = 0.0;
+                for (int j = 0; j < n; ++j) acc += a[size_t(i) * n + j] * x[j];
+                tmp[i] = acc;
+            }
+            x.swap(tmp);
+        }
+        at = horizons[idx];
+        out[idx] = x[c.lvl0];                      // 第 h 步後的 level[0] = ŷ_{t+h}
+    }
+}
+
+//------------------------------------------------------------
+// 預測區間 ‒ ψ 權重展開 (每個模型算一次)，var_h = σ² Σ_{j<h} ψ_j²
+//------------------------------------------------------------
+// 單位衝擊 ε_t = 1 (未來衝擊為 0) 經同一遞迴傳到 ŷ_{t+j} 的量即 ψ_j，j = 0..h-1 (h = psi.size())
+inline void arima_psi_weights(const ArimaModelView& m, Span<double> psi) {
+    const int h = int(psi.size());
+    const int lv = std::max(m.d, 1);
+    std::vector<double> lag(m.p, 0.0), eps(m.q, 0.0), lvl(lv, 0.0);
+    for (int j = 0; j < h; ++j) {
+        double dhat = (j == 0) ? 1.0 : 0.0;
+        for (int i = 0; i < m.p; ++i) dhat += m.phi[i] * lag[i];
+        for (int k = 0; k < m.q; ++k) dhat += m.theta[k] * eps[k];
+        double carry = dhat;
+        for (int k = lv - 1; k >= 0; --k) {
+            lvl[k] += carry;
+            carry = lvl[k];
+        }
+        if (m.p > 0) { std::rotate(lag.rbegin(), lag.rbegin() + 1, lag.rend()); lag[0] = (m.d == 0) ? carry : dhat; }
+        if (m.q > 0) { std::rotate(eps.rbegin(), eps.rbegin() + 1, eps.rend()); eps[0] = (j == 0) ? 1.0 : 0.0; }
+        psi[j] = carry;
+    }
+}
+
+// 常用信賴水準的雙尾常態分位數
+inline bool interval_z(int level, double& z) {
+    switch (level) {
+        case 50: z = 0.6744897502; return true;
+        case 80: z = 1.2815515655; return true;
+        case 90: z = 1.6448536270; return true;
+        case 95: z = 1.9599639845; return true;
+        case 99: z = 2.5758293035; return true;
+        default:
+            std::cerr << "Error: unsupported interval level " << level << " (use 50/80/90/95/99)\n";
+            return false;
+    }
+}
+
+/* 預測區間：sd[h] 只依模型與 horizon 而定 (建構時算好)，
+ * 之後每次預測只剩逐元素的 y ± z·sd，與 forecast 本身相比是常數級開銷 */
+struct ArimaIntervals {
+    std::vector<int>    levels;
+    std::vector<double> z;
+    std::vector<double> sd;                        // [h] 預測誤差標準差
+
+    bool init(const ArimaModelView& m, int h, Span<const int> lv) {
+        levels.assign(lv.begin(), lv.end());
+        z.resize(levels.size());
+        for (size_t i = 0; i < levels.size(); ++i)
+            if (!interval_z(levels[i], z[i])) return false;
+        sd.resize(h);
+        arima_psi_weights(m, sd);
+        for (int j = 0; j < h; ++j) sd[j] *= sd[j];                      // ψ²
+        for (int j = 1; j < h; ++j) sd[j] += sd[j - 1];                  // Σ ψ²
+        for (int j = 0; j < h; ++j) sd[j] = std::sqrt(m.sigma2 * sd[j]);
+        return true;
+    }
+
+    // y: [h] 點預測；bands: [levels][2][h] → lower / upper
+    void apply(Span<const double> y, Span<double> bands) const {
+        const int h = int(y.size());
+        for (size_t l = 0; l < z.size(); ++l) {
+            double* lo = bands.data() + (2 * l) * h;
+            double* hi = lo + h;
+            const double zl = z[l];
+            for (int j = 0; j < h; ++j) {
+                lo[j] = y[j] - zl * sd[j];
+                hi[j] = y[j] + zl * sd[j];
+            }
+        }
+    }
+};
@@ -0,0 +1,111 @@
+#pragma once
+//------------------------------------------------------------
+// Kalman 形式的 ARIMA 預測器 (header-only)：KalmanArima，伴隨矩陣取自 arima_horizon.h
+//------------------------------------------------------------
+#include <algorithm>
+#include <vector>
+
+#include "arima.h"
+#include "arima_horizon.h"
+
+//------------------------------------------------------------
+// 狀態空間 / Kalman 預測 ‒ 容忍缺值與不規則時間戳。
+// 狀態同 build_companion()：x = [lag(p), ε(q), level(max(d,1)), 1]，
+// x_{t+1} = A x_t + r η_{t+1}，η ~ N(0, σ²)；r 在新 lag、新 ε 與每個 level 為 1。
+// 觀測 y_t = level[0] (無量測雜訊)。沒有缺值時增益恰為 r，結果與 observe() 相同；
+// 缺值的時間格只做預測步 (P 隨之放大)，下一筆觀測再依 P 修正被跳過的 lag / ε。
+// 每個時間格成本 O(n²)~O(n³)，n = p + q + max(d,1) + 1，與歷史長度無關
+//------------------------------------------------------------
+class KalmanArima {
+public:
+    // 以 history 最後 max(p+d,1) 筆 (須連續、無缺值) 建立確定的起始狀態 (P = 0)
+    bool init(const ArimaModelView& m, const double* history, size_t len) {
+        ArimaForecaster f;
+        if (!f.init(m, history, len)) return false;
+        c_ = build_companion(m);
+        n_ = c_.n;
+        sigma2_ = m.sigma2 > 0.0 ? m.sigma2 : 1.0;   // 只影響 P 的尺度，增益與點預測不變
+        x_.assign(n_, 0.0);
+        std::copy(f.lags(),   f.lags()   + c_.p,  x_.begin() + c_.lag0);
+        std::copy(f.resids(), f.resids() + c_.q,  x_.begin() + c_.eps0);
+        std::copy(f.levels(), f.levels() + c_.lv, x_.begin() + c_.lvl0);
+        x_[c_.one] = 1.0;
+        r_.assign(n_, 0.0);
+        if (c_.p > 0) r_[c_.lag0] = 1.0;
+        if (c_.q > 0) r_[c_.eps0] = 1.0;
+        for (int k = 0; k < c_.lv; ++k) r_[c_.lvl0 + k] = 1.0;
+        P_.assign(size_t(n_) * n_, 0.0);
+        AP_.assign(size_t(n_) * n_, 0.0);
+        tmp_.assign(n_, 0.0);
+        gain_.assign(n_, 0.0);
+        return true;
+    }
+    bool init(const ArimaModelView& m, Span<const double> history) { return init(m, history.data(), history.size()); }
+
+    // 前進一個時間格 (只預測)：x ← A x，P ← A P A' + σ² r r'
+    void predict() {
+        const int n = n_;
+        const double* A = c_.A.data();
+        mat_vec(A, x_.data(), tmp_.data());
+        x_.swap(tmp_);
+        std::fill(AP_.begin(), AP_.end(), 0.0);
+        for (int i = 0; i < n; ++i)
+            for (int k = 0; k < n; ++k) {
+                const double aik = A[size_t(i) * n + k];
+                if (aik == 0.0) continue;
+                for (int j = 0; j < n; ++j) AP_[size_t(i) * n + j] += aik * P_[size_t(k) * n + j];
+            }
+        for (int i = 0; i < n; ++i)
+            for (int j = 0; j < n; ++j) {
+                double acc = sigma2_ * r_[i] * r_[j];
+                const double* ap = &AP_[size_t(i) * n];
+                const double* a  = &A[size_t(j) * n];
+                for (int k = 0; k < n; ++k) acc += ap[k] * a[k];
+                P_[size_t(i) * n + j] = acc;
+            }
+    }
+
+    // 以觀測 y 更新目前時間格；回傳創新 v = y - ŷ
+    double update(double y) {
+        const int n = n_, h = c_.lvl0;
+        const double v = y - x_[h];
+        const double S = P_[size_t(h) * n + h];
+        if (!(S > 0.0)) return v;                  // 狀態已確定 (未先 predict)
+        for (int i = 0; i < n; ++i) gain_[i] = P_[size_t(i) * n + h] / S;
+        for (int i = 0; i < n; ++i) x_[i] += gain_[i] * v;
+        for (int j = 0; j < n; ++j) tmp_[j] = P_[size_t(h) * n + j];
+        for (int i = 0; i < n; ++i)
+            for (int j = 0; j < n; ++j) P_[size_t(i) * n + j] -= gain_[i] * tmp_[j];
+        return v;
+    }
+
+    // 從目前狀態往後預測 n_steps 步；不改變濾波狀態
+    void forecast(double* out, int n_steps) {
+        std::copy(x_.begin(), x_.end(), AP_.begin());   // AP_ 當暫存：[0, n) 為 x，[n, 2n) 為 A x
+        double* a = AP_.data();
+        double* b = AP_.data() + n_;
+        for (int step = 0; step < n_steps; ++step) {
+            mat_vec(c_.A.data(), a, b);
+            std::swap(a, b);
+            out[step] = a[c_.lvl0];
+        }
+    }
+    void forecast(Span<double> out) { forecast(out.data(), int(out.size())); }
+
+    double level() const { return x_[c_.lvl0]; }
+    double level_var() const { return P_[size_t(c_.lvl0) * n_ + c_.lvl0]; }
+
+private:
+    void mat_vec(const double* A, const double* v, double* out) const {
+        for (int i = 0; i < n_; ++i) {
+            double acc = 0.0;
+            for (int j = 0; j < n_; ++j) acc += A[size_t(i) * n_ + j] * v[j];
+            out[i] = acc;
+        }
+    }
+
+    ArimaCompanion c_;
+    int n_ = 0;
+    double sigma2_ = 1.0;
+    std::vector<double> x_, r_, P_, AP_, tmp_, gain_;
+};
@@ -0,0 +1,156 @@
+#pragma once
+//------------------------------------------------------------
+// 季節與外生變數模型 (header-only)：SarimaForecaster (稀疏落後展開的 SARIMA) 與
+// ARIMAX 的迴歸項 (ExogMatrix / exog_regression)。ARIMAX 為「迴歸 + ARIMA 誤差」：
+// 歷史先扣掉 x·β 再以 (S)ARIMA 預測，最後加回未來的 x·β
+//------------------------------------------------------------
+#include <algorithm>
+#include <iostream>
+#include <map>
+#include <vector>
+
+#include "arima.h"
+
+//------------------------------------------------------------
+// 季節 SARIMA(p,d,q)(P,D,Q)_s ‒ 乘法多項式展開成稀疏落後：
+//   AR  (1 - φ(B))(1 - Φ(B^s))，MA (1 + θ(B))(1 + Θ(B^s))，差分 (1-B)^d (1-B^s)^D
+// 每個非零落後 L 只保留預測 horizon 內會讀到的 min(H, L) 筆歷史，
+// 記憶體 O(非零落後數 × H)、每步成本 O(非零落後數)，與 s 無關
+//------------------------------------------------------------
+class SarimaForecaster {
+public:
+    /* history 需至少 d + sD + (p + sP) + 1 筆；MA 殘差由歷史以條件平方和方式
+     * 重建 (最早的殘差取 0)。max_steps = 之後 forecast() 的最大步數。
+     * 不接受 d = D = 0：非季節路徑在 d = 0 時把 ARMA 值加在最後一筆觀測上，這裡則直接輸出，兩者會不一致 */
+    bool init(const ArimaParams& m, Span<const double> history, int max_steps) {
+        if (m.d == 0 && m.D == 0) {
+            std::cerr << "Error: seasonal models need d ≥ 1 or D ≥ 1; with d = D = 0 the non-seasonal forecaster "
+                         "adds the ARMA value to the last observation, which the seasonal one does not\n";
+            return false;
+        }
+        std::map<int, double> ar, ma, df;
+        for (int i = 1; i <= m.p; ++i) ar[i] += m.phi[i - 1];
+        for (int k = 1; k <= m.P; ++k) {
+            ar[m.s * k] += m.sphi[k - 1];
+            for (int i = 1; i <= m.p; ++i) ar[m.s * k + i] -= m.phi[i - 1] * m.sphi[k - 1];
+        }
+        for (int j = 1; j <= m.q; ++j) ma[j] += m.theta[j - 1];
+        for (int k = 1; k <= m.Q; ++k) {
+            ma[m.s * k] += m.stheta[k - 1];
+            for (int j = 1; j <= m.q; ++j) ma[m.s * k + j] += m.theta[j - 1] * m.stheta[k - 1];
+        }
+        /* Δ(B) = Σ δ_l B^l，w_t = Σ δ_l y_{t-l}；y 的遞迴用 -δ_l (l ≥ 1) */
+        std::vector<double> delta{1.0};
+        auto times = [&](int lag) {                       // delta *= (1 - B^lag)
+            std::vector<double> out(delta.size() + lag, 0.0);
+            for (size_t l = 0; l < delta.size(); ++l) { out[l] += delta[l]; out[l + lag] -= delta[l]; }
+            delta.swap(out);
+        };
+        for (int k = 0; k < m.d; ++k) times(1);
+        for (int k = 0; k < m.D; ++k) times(m.s);
+        for (size_t l = 1; l < delta.size(); ++l) if (delta[l] != 0.0) df[int(l)] = -delta[l];
+
+        const long Ld = long(delta.size()) - 1;
+        const long La = ar.empty() ? 0 : ar.rbegin()->first;
+        const long n  = long(history.size());
+        if (n < Ld + La + 1) {
+            std::cerr << "Error: seasonal model needs at least d + sD + p + sP + 1 = "
+                      << Ld + La + 1 << " history points\n";
+            return false;
+        }
+        mu_ = m.mu;
+        H_ = max_steps;
+
+        /* 暫時展開整段 w、ε (只在 init 期間存在) */
+        std::vector<double> w(n, 0.0), e(n, 0.0);
+        for (long t = Ld; t < n; ++t) {
+            double v = 0.0;
+            for (size_t l = 0; l < delta.size(); ++l) v += delta[l] * history[t - l];
+            w[t] = v;
+        }
+        for (long t = Ld + La; t < n; ++t) {
+            double pred = mu_;
+            for (const auto& [L, c] : ar) pred += c * w[t - L];
+            for (const auto& [L, c] : ma) if (t - L >= 0) pred += c * e[t - L];
+            e[t] = w[t] - pred;
+        }
+        ar_.build(ar, w, H_);
+        ma_.build(ma, e, H_);
+        df_.build(df, history, H_);
+        w_fut_.assign(H_, 0.0);
+        y_fut_.assign(H_, 0.0);
+        return true;
+    }
+
+    // 預測 n_steps ≤ max_steps 步；ε 的未來值取 0
+    void forecast(double* out, int n_steps) {
+        for (int k = 1; k <= n_steps; ++k) {
+            const double w_hat = mu_ + ar_.dot(k, w_fut_.data()) + ma_.dot(k, nullptr);
+            w_fut_[k - 1] = w_hat;
+            y_fut_[k - 1] = w_hat + df_.dot(k, y_fut_.data());
+            out[k - 1] = y_fut_[k - 1];
+        }
+    }
+    void forecast(Span<double> out) { forecast(out.data(), int(out.size())); }
+
+    size_t nonzero_lags() const { return ar_.lag.size() + ma_.lag.size() + df_.lag.size(); }
+    size_t stored_values() const { return ar_.win.size() + ma_.win.size() + df_.win.size() + 2 * size_t(H_); }
+
+private:
+    /* 稀疏落後：lag[i] 的係數 coef[i]；win[off[i] .. off[i] + min(H, lag[i])) 存
+     * 原點 t 的 x_{t-lag+1}, x_{t-lag+2}, ...，即第 k 步 (k ≤ lag) 讀到的 x_{t+k-lag} */
+    struct SparseLags {
+        std::vector<int> lag;
+        std::vector<double> coef, win;
+        std::vector<size_t> off;
+        void build(const std::map<int, double>& terms, Span<const double> x, int H) {
+            const long t = long(x.size()) - 1;
+            lag.clear(); coef.clear(); win.clear(); off.clear();
+            for (const auto& [L, c] : terms) {
+                if (c == 0.0) continue;
+                lag.push_back(L);
+                coef.push_back(c);
+                off.push_back(win.size());
+                for (long j = 0; j < std::min<long>(H, L); ++j) {
+                    const long idx = t - L + 1 + j;
+                    win.push_back(idx >= 0 ? x[idx] : 0.0);
+                }
+            }
+        }
+        // 第 k 步 (1-based) 的 Σ coef·x_{t+k-lag}；k > lag 時讀已預測的 fut[k-lag-1] (nullptr = 0)
+        double dot(int k, const double* fut) const {
+            double sum = 0.0;
+            for (size_t i = 0; i < lag.size(); ++i) {
+                const int L = lag[i];
+                const double x = k <= L ? win[off[i] + k - 1] : (fut ? fut[k - L - 1] : 0.0);
+                sum += coef[i] * x;
+            }
+            return sum;
+        }
+    };
+
+    double mu_ = 0.0;
+    int H_ = 0;
+    SparseLags ar_, ma_, df_;                    // w 的 AR、ε 的 MA、y 的差分還原
+    std::vector<double> w_fut_, y_fut_;          // 已預測的 ŵ / ŷ
+};
+
+/* 外生變數矩陣，欄優先連續存放：第 j 欄為 data[j * rows .. (j+1) * rows) */
+struct ExogMatrix {
+    int k = 0;
+    size_t rows = 0;
+    std::vector<double> data;
+    const double* col(int j) const { return data.data() + size_t(j) * rows; }
+};
+
+/* reg[t] = Σ_j β_j x_j[t], t < reg.size() ≤ X.rows。逐欄 axpy：內層沿時間連續存取可向量化，
+ * 相當於一次算完 n 步的點積，10 幾個變數也只是 10 幾趟連續掃描 */
+inline void exog_regression(const ExogMatrix& X, Span<const double> beta, Span<double> reg) {
+    const size_t n = reg.size();
+    std::fill_n(reg.data(), n, 0.0);
+    for (int j = 0; j < X.k; ++j) {
+        const double b = beta[j];
+        const double* x = X.col(j);
+        for (size_t t = 0; t < n; ++t) reg[t] += b * x[t];
+    }
+}
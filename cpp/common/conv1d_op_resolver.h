@@ -0,0 +1,20 @@
+#pragma once
+//------------------------------------------------------------
+// 由 cpp/tools/gen_op_resolver.py 產生，請勿手動修改。來源模型：
+//   cls_1dcnn_forda_0612.tflite
+// 只註冊上述模型用到的 builtin op；以 -DTFLITE_MINIMAL_OPS 編譯時取代 BuiltinOpResolver
+//------------------------------------------------------------
+#include "tensorflow/lite/kernels/builtin_op_kernels.h"
+#include "tensorflow/lite/mutable_op_resolver.h"
+
+class MinimalOpResolver : public tflite::MutableOpResolver {
+public:
+    MinimalOpResolver() {
+        AddBuiltin(tflite::BuiltinOperator_CONV_2D, tflite::ops::builtin::Register_CONV_2D(), 1, 1);
+        AddBuiltin(tflite::BuiltinOperator_EXPAND_DIMS, tflite::ops::builtin::Register_EXPAND_DIMS(), 1, 1);
+        AddBuiltin(tflite::BuiltinOperator_FULLY_CONNECTED, tflite::ops::builtin::Register_FULLY_CONNECTED(), 1, 1);
+        AddBuiltin(tflite::BuiltinOperator_MEAN, tflite::ops::builtin::Register_MEAN(), 1, 1);
+        AddBuiltin(tflite::BuiltinOperator_RESHAPE, tflite::ops::builtin::Register_RESHAPE(), 1, 1);
+        AddBuiltin(tflite::BuiltinOperator_SOFTMAX, tflite::ops::builtin::Register_SOFTMAX(), 1, 1);
+    }
+};
@@ -0,0 +1,265 @@
+#pragma once
+//------------------------------------------------------------
+// 三個 demo 共用的數值 CSV 讀取 (header-only)
+// 整檔 mmap (不可 mmap 時改以大區塊整檔讀入)，以 std::from_chars 解析，
+// 不丟例外；支援多欄、表頭略過與無效值計數，以及只讀檔尾 n 筆
+//
+// 解析規則沿用原本 std::getline + std::stod 的行為：
+//   - 空行略過；欄位前的空白與 '+' 略過，數字之後的內容忽略 (同 stod)
+//   - 第一個非空行若無法解析，視為表頭 (auto_header)，其餘無法解析的行計入 invalid
+//------------------------------------------------------------
+#include <algorithm>
+#include <charconv>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <string>
+#include <vector>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// libstdc++ 11 起 from_chars 才支援浮點數；較舊的工具鏈 (如 dunfell 的 GCC 9) 改用 strtod
+#if defined(__cpp_lib_to_chars) || (defined(_GLIBCXX_RELEASE) && _GLIBCXX_RELEASE >= 11)
+#define CSV_HAVE_FLOAT_FROM_CHARS 1
+#endif
+
+struct CsvOptions {
+    char   delim       = ',';
+    size_t skip_rows   = 0;       // 開頭固定略過的行數 (不論內容)
+    bool   auto_header = true;    // 第一個非空行無法解析時視為表頭
+    size_t column      = 0;       // 單欄讀取時取第幾欄 (0 起算)
+};
+
+struct CsvStats {
+    size_t lines   = 0;           // 掃過的行數 (含空行、表頭)
+    size_t blank   = 0;           // 空行
+    size_t header  = 0;           // 略過的表頭 / skip_rows
+    size_t invalid = 0;           // 無法解析或欄數不符而略過的行
+    size_t values  = 0;           // 成功解析的數值個數
+};
+
+// 唯讀映射整個檔案；檔案不可 mmap (管線、特殊檔) 時整檔讀進記憶體
+class CsvFile {
+public:
+    CsvFile() = default;
+    CsvFile(const CsvFile&) = delete;
+    CsvFile& operator=(const CsvFile&) = delete;
+    ~CsvFile() { if (map_) munmap(map_, size_); }
+
+    bool open(const std::string& filename, bool sequential = true) {
+        int fd = ::open(filename.c_str(), O_RDONLY);
+        if (fd < 0) return false;
+        struct stat st{};
+        if (fstat(fd, &st) == 0 && S_ISREG(st.st_mode)) {
+            size_ = size_t(st.st_size);
+            if (size_ == 0) { ::close(fd); return true; }
+            void* p = mmap(nullptr, size_, PROT_READ, MAP_PRIVATE, fd, 0);
+            if (p != MAP_FAILED) {
+                map_ = p;
+                if (sequential) madvise(map_, size_, MADV_SEQUENTIAL);
+                ::close(fd);
+                return true;
+            }
+        }
+        ::close(fd);
+        std::ifstream f(filename, std::ios::binary);
+        if (!f.is_open()) return false;
+        copy_.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+        size_ = copy_.size();
+        return true;
+    }
+
+    const char* begin() const { return map_ ? static_cast<const char*>(map_) : copy_.data(); }
+    const char* end()   const { return begin() + size_; }
+    size_t size() const { return size_; }
+
+private:
+    void* map_ = nullptr;
+    size_t size_ = 0;
+    std::string copy_;
+};
+
+/* 從 [p, end) 解析一個數值：略過前導空白與 '+'，成功回傳數字之後的位置，
+ * 失敗回傳 nullptr。不配置記憶體、不丟例外 */
+template <typename T>
+inline const char* csv_parse_number(const char* p, const char* end, T& out) {
+    while (p < end && (*p == ' ' || *p == '\t' || *p == '\r' || *p == '\v' || *p == '\f')) ++p;
+    if (p < end && *p == '+') ++p;
+#ifdef CSV_HAVE_FLOAT_FROM_CHARS
+    auto r = std::from_chars(p, end, out);
+    if (r.ec != std::errc()) return nullptr;
+    return r.ptr;
+#else
+    char buf[64];
+    const size_t n = std::min<size_t>(size_t(end - p), sizeof(buf) - 1);
+    std::memcpy(buf, p, n);
+    buf[n] = '\0';
+    char* stop = nullptr;
+    const double v = std::strtod(buf, &stop);
+    if (stop == buf) return nullptr;
+    out = T(v);
+    return p + (stop - buf);
+#endif
+}
+
+// 取一行中第 col 個欄位 [b, e)；欄位不足回傳 false
+inline bool csv_field(const char* line, const char* line_end, char delim, size_t col,
+                      const char*& b, const char*& e) {
+    b = line;
+    for (size_t c = 0; c < col; ++c) {
+        const char* d = static_cast<const char*>(std::memchr(b, delim, size_t(line_end - b)));
+        if (!d) return false;
+        b = d + 1;
+    }
+    e = static_cast<const char*>(std::memchr(b, delim, size_t(line_end - b)));
+    if (!e) e = line_end;
+    return true;
+}
+
+// 把一行依分隔字元切成字串 (表頭欄名用)
+inline void csv_split(const char* line, const char* line_end, char delim, std::vector<std::string>& out) {
+    for (const char* b = line;;) {
+        const char* e = static_cast<const char*>(std::memchr(b, delim, size_t(line_end - b)));
+        if (!e) e = line_end;
+        out.emplace_back(b, e);
+        if (e == line_end) break;
+        b = e + 1;
+    }
+}
+
+// 逐行走訪 [begin, end)，fn(line, line_end)；行不含 '\n' 及 CRLF 的 '\r'，檔尾換行後不多出空行 (同 getline)
+template <class Fn>
+inline void csv_for_each_line(const char* begin, const char* end, Fn fn) {
+    const char* p = begin;
+    while (p < end) {
+        const char* nl = static_cast<const char*>(std::memchr(p, '\n', size_t(end - p)));
+        const char* le = nl ? nl : end;
+        fn(p, (le > p && le[-1] == '\r') ? le - 1 : le);
+        p = nl ? nl + 1 : end;
+    }
+}
+
+/* 讀取單欄 (opts.column) 的所有數值，取代 load_history / read_csv。
+ * 檔案無法開啟回傳 false */
+template <typename T>
+bool csv_read_column(const std::string& filename, std::vector<T>& out,
+                     const CsvOptions& opts = {}, CsvStats* stats = nullptr) {
+    CsvFile file;
+    if (!file.open(filename)) return false;
+    CsvStats st;
+    bool seen_data = false;
+    out.clear();
+    out.reserve(file.size() / 8);
+    csv_for_each_line(file.begin(), file.end(), [&](const char* line, const char* le) {
+        ++st.lines;
+        if (st.lines <= opts.skip_rows) { ++st.header; return; }
+        if (line == le) { ++st.blank; return; }
+        const char *b, *e;
+        T v;
+        if (csv_field(line, le, opts.delim, opts.column, b, e) && csv_parse_number(b, e, v)) {
+            out.push_back(v);
+            seen_data = true;
+        } else if (opts.auto_header && !seen_data && st.header == opts.skip_rows) {
+            ++st.header;
+            seen_data = true;
+        } else {
+            ++st.invalid;
+        }
+    });
+    st.values = out.size();
+    if (stats) *stats = st;
+    return true;
+}
+
+/* 讀取多欄：每欄一條序列。第一個非空行若有欄位無法解析即為表頭 (欄名寫入 names)；
+ * 欄數以第一個資料行為準，欄數不符或含無法解析欄位的行計入 invalid */
+template <typename T>
+bool csv_read_columns(const std::string& filename, std::vector<std::string>& names,
+                      std::vector<std::vector<T>>& cols,
+                      const CsvOptions& opts = {}, CsvStats* stats = nullptr) {
+    CsvFile file;
+    if (!file.open(filename)) return false;
+    CsvStats st;
+    bool first = true;
+    std::vector<T> row;
+    csv_for_each_line(file.begin(), file.end(), [&](const char* line, const char* le) {
+        ++st.lines;
+        if (st.lines <= opts.skip_rows) { ++st.header; return; }
+        if (line == le) { ++st.blank; return; }
+        row.clear();
+        bool ok = true;
+        for (const char* b = line;;) {
+            if (b == le && !row.empty()) break;            // 行尾多一個分隔字元 (同 getline 不產生空欄)
+            const char* e = static_cast<const char*>(std::memchr(b, opts.delim, size_t(le - b)));
+            if (!e) e = le;
+            T v;
+            if (!csv_parse_number(b, e, v)) { ok = false; break; }
+            row.push_back(v);
+            if (e == le) break;
+            b = e + 1;
+        }
+        if (!ok) {
+            if (first && opts.auto_header) {
+                ++st.header;
+                names.clear();
+                csv_split(line, le, opts.delim, names);
+            } else {
+                ++st.invalid;
+            }
+            first = false;
+            return;
+        }
+        first = false;
+        if (cols.empty()) cols.resize(row.size());
+        if (row.size() != cols.size()) { ++st.invalid; return; }
+        for (size_t c = 0; c < row.size(); ++c) cols[c].push_back(row[c]);
+        st.values += row.size();
+    });
+    if (stats) *stats = st;
+    return true;
+}
+
+/* 只讀檔尾最後 n 個有效數值 (單欄 opts.column)：mmap 後自檔尾往前找換行，
+ * 只有被碰到的頁面會讀入，耗時與檔案大小無關。略過規則同 csv_read_column
+ * (表頭只可能出現在檔頭，讀到檔頭時才判定；skip_rows 不適用) */
+template <typename T>
+bool csv_read_tail(const std::string& filename, size_t n, std::vector<T>& out,
+                   const CsvOptions& opts = {}, CsvStats* stats = nullptr) {
+    CsvFile file;
+    if (!file.open(filename, false)) return false;
+    CsvStats st;
+    out.clear();
+    const char* begin = file.begin();
+    const char* le = file.end();
+    if (le > begin && le[-1] == '\n') --le;                 // 檔尾換行不多出一行
+    bool pending_first = false;                             // 最早的無效行 (可能是表頭)
+    while (out.size() < n && file.size() > 0) {
+        const char* line = le;
+        while (line > begin && line[-1] != '\n') --line;
+        const char* next = line > begin ? line - 1 : line;  // 下一輪的行尾 (此行之前的 '\n')
+        if (le > line && le[-1] == '\r') --le;
+        ++st.lines;
+        const char *b, *e;
+        T v;
+        if (line == le) {
+            ++st.blank;
+        } else if (csv_field(line, le, opts.delim, opts.column, b, e) && csv_parse_number(b, e, v)) {
+            out.push_back(v);
+            pending_first = false;
+        } else {
+            ++st.invalid;
+            pending_first = true;
+        }
+        if (line == begin) break;
+        le = next;
+    }
+    // 讀到檔頭且最早的非空行無法解析 → 與 csv_read_column 一致當作表頭
+    if (pending_first && opts.auto_header && out.size() < n) { --st.invalid; ++st.header; }
+    std::reverse(out.begin(), out.end());
+    st.values = out.size();
+    if (stats) *stats = st;
+    return true;
+}
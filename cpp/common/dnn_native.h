@@ -0,0 +1,405 @@
+#pragma once
+//------------------------------------------------------------
+// AR-DNN 原生推理 (header-only，不需 TFLite runtime)
+// 直接從 .tflite flatbuffer 取出 FullyConnected 層的權重與偏置，以 GEMV+ReLU 核心計算：
+//   - 已知拓樸 (10→16→32→16→1) 走編譯期固定層大小的核心，AVX2 (x86，執行期偵測) / NEON (aarch64)
+//   - 其他層大小走執行期大小的純量路徑
+// 只接受 float32、activation 為 NONE/RELU 的 FullyConnected 串接模型；
+// 其他模型 load 回傳 false，由呼叫端改用 TFLite 直譯器
+//------------------------------------------------------------
+#include <algorithm>
+#include <cstdint>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#include <string>
+#include <vector>
+#if defined(__x86_64__) || defined(__i386__)
+#include <immintrin.h>
+#elif defined(__aarch64__)
+#include <arm_neon.h>
+#endif
+
+// 一層全連接：權重轉置存成 [in][out]，GEMV 時每個輸入廣播後沿輸出方向向量化
+struct DenseLayer {
+    int in = 0, out = 0;
+    bool relu = false;
+    std::vector<float> wt;      // [in][out]
+    std::vector<float> bias;    // [out]
+};
+
+//------------------------------------------------------------
+// 最小 flatbuffer 讀取：只實作 TFLite schema 用到的 table / vector / scalar，
+// 每次讀取都檢查邊界，檔案損壞時 ok() 變 false 而不越界
+//------------------------------------------------------------
+class FlatbufferView {
+public:
+    FlatbufferView(const uint8_t* data, size_t size) : p_(data), n_(size) {}
+
+    bool ok() const { return ok_; }
+
+    template <typename T>
+    T read(size_t pos) {
+        if (pos > n_ || n_ - pos < sizeof(T)) { ok_ = false; return T(0); }
+        T v;
+        std::memcpy(&v, p_ + pos, sizeof(T));
+        return v;
+    }
+
+    // uoffset：自 pos 起算的相對位移
+    size_t deref(size_t pos) { return pos + read<uint32_t>(pos); }
+    size_t root() { return deref(0); }
+
+    // table 第 id 個欄位的位置，欄位不存在回傳 0
+    size_t field(size_t table, int id) {
+        const int64_t vt = int64_t(table) - read<int32_t>(table);
+        if (vt < 0) { ok_ = false; return 0; }
+        const uint16_t vt_size = read<uint16_t>(size_t(vt));
+        if (size_t(4 + 2 * id) >= vt_size) return 0;
+        const uint16_t off = read<uint16_t>(size_t(vt) + 4 + 2 * id);
+        return off ? table + off : 0;
+    }
+
+    template <typename T>
+    T scalar(size_t table, int id, T def) {
+        const size_t f = field(table, id);
+        return f ? read<T>(f) : def;
+    }
+
+    // vector 欄位：回傳第一個元素的位置，n 為元素數；欄位不存在時 n = 0
+    size_t vec(size_t table, int id, size_t elem_size, uint32_t& n) {
+        n = 0;
+        const size_t f = field(table, id);
+        if (!f) return 0;
+        const size_t v = deref(f);
+        n = read<uint32_t>(v);
+        if (v + 4 > n_ || (n_ - v - 4) / elem_size < n) { ok_ = false; n = 0; return 0; }
+        return v + 4;
+    }
+
+    size_t table_at(size_t vec_start, uint32_t i) { return deref(vec_start + 4 * size_t(i)); }
+    const uint8_t* data() const { return p_; }
+    size_t size() const { return n_; }
+
+private:
+    const uint8_t* p_;
+    size_t n_;
+    bool ok_ = true;
+};
+
+/* 從 .tflite 取出依序串接的 FullyConnected 層 (第一個 subgraph)。
+ * 圖中任一運算不是 FullyConnected、非 float32、或前後層沒有直接相接時回傳 false */
+inline bool tflite_extract_dense(const uint8_t* data, size_t size, std::vector<DenseLayer>& layers) {
+    // TFLite schema 中用到的欄位編號與列舉值
+    enum { kModelOpcodes = 1, kModelSubgraphs = 2, kModelBuffers = 4 };
+    enum { kGraphTensors = 0, kGraphInputs = 1, kGraphOutputs = 2, kGraphOperators = 3 };
+    enum { kTensorShape = 0, kTensorType = 1, kTensorBuffer = 2 };
+    enum { kOpOpcode = 0, kOpInputs = 1, kOpOutputs = 2, kOpOptions = 4 };
+    constexpr int32_t kFullyConnected = 9;
+    constexpr int8_t kFloat32 = 0, kActNone = 0, kActRelu = 1;
+
+    layers.clear();
+    if (size < 8 || std::memcmp(data + 4, "TFL3", 4) != 0) {
+        std::cerr << "Not a TFLite flatbuffer\n"; return false;
+    }
+    FlatbufferView fb(data, size);
+    const size_t model = fb.root();
+    uint32_t n_codes = 0, n_graphs = 0, n_bufs = 0;
+    const size_t codes = fb.vec(model, kModelOpcodes, 4, n_codes);
+    const size_t graphs = fb.vec(model, kModelSubgraphs, 4, n_graphs);
+    const size_t bufs = fb.vec(model, kModelBuffers, 4, n_bufs);
+    if (!fb.ok() || n_graphs == 0) { std::cerr << "TFLite model has no subgraph\n"; return false; }
+
+    const size_t graph = fb.table_at(graphs, 0);
+    uint32_t n_tensors = 0, n_in = 0, n_out = 0, n_ops = 0;
+    const size_t tensors = fb.vec(graph, kGraphTensors, 4, n_tensors);
+    const size_t g_in = fb.vec(graph, kGraphInputs, 4, n_in);
+    const size_t g_out = fb.vec(graph, kGraphOutputs, 4, n_out);
+    const size_t ops = fb.vec(graph, kGraphOperators, 4, n_ops);
+    if (!fb.ok() || n_in != 1 || n_out != 1 || n_ops == 0) {
+        std::cerr << "TFLite graph must have one input, one output and at least one operator\n"; return false;
+    }
+
+    // 張量的 shape 與常數資料 (float32)；無常數資料時 values 為空
+    auto tensor_info = [&](int32_t idx, std::vector<int32_t>& shape, std::vector<float>& values) -> bool {
+        if (idx < 0 || uint32_t(idx) >= n_tensors) return false;
+        const size_t t = fb.table_at(tensors, uint32_t(idx));
+        if (fb.scalar<int8_t>(t, kTensorType, kFloat32) != kFloat32) return false;
+        uint32_t rank = 0;
+        const size_t s = fb.vec(t, kTensorShape, 4, rank);
+        shape.resize(rank);
+        for (uint32_t k = 0; k < rank; ++k) shape[k] = fb.read<int32_t>(s + 4 * k);
+        values.clear();
+        const uint32_t b = fb.scalar<uint32_t>(t, kTensorBuffer, 0);
+        if (b == 0 || b >= n_bufs) return fb.ok();
+        const size_t buf = fb.table_at(bufs, b);
+        uint32_t n_bytes = 0;
+        size_t bytes = fb.vec(buf, 0, 1, n_bytes);
+        if (n_bytes == 0) {                                  // 大模型把資料放在 flatbuffer 之後 (offset/size)
+            const uint64_t off = fb.scalar<uint64_t>(buf, 1, 0), len = fb.scalar<uint64_t>(buf, 2, 0);
+            if (off > 1 && off <= size && len <= size - off) { bytes = size_t(off); n_bytes = uint32_t(len); }
+        }
+        if (n_bytes % sizeof(float) != 0) return false;
+        values.resize(n_bytes / sizeof(float));
+        if (n_bytes) std::memcpy(values.data(), data + bytes, n_bytes);
+        return fb.ok();
+    };
+
+    int32_t cur = fb.read<int32_t>(g_in);                   // 目前層的輸入張量
+    std::vector<int32_t> shape;
+    std::vector<float> values;
+    if (!tensor_info(cur, shape, values) || shape.empty()) { std::cerr << "Unsupported input tensor\n"; return false; }
+    int width = shape.back();
+
+    for (uint32_t k = 0; k < n_ops; ++k) {
+        const size_t op = fb.table_at(ops, k);
+        const uint32_t code_idx = fb.scalar<uint32_t>(op, kOpOpcode, 0);
+        if (code_idx >= n_codes) { std::cerr << "Invalid opcode index\n"; return false; }
+        const size_t code = fb.table_at(codes, code_idx);
+        // builtin_code (新欄位) 與 deprecated_builtin_code 取較大者，同 TFLite 的 GetBuiltinCode
+        const int32_t builtin = std::max<int32_t>(fb.scalar<int8_t>(code, 0, 0), fb.scalar<int32_t>(code, 3, 0));
+        if (builtin != kFullyConnected) { std::cerr << "Operator " << k << " is not FullyConnected\n"; return false; }
+
+        uint32_t n_op_in = 0, n_op_out = 0;
+        const size_t op_in = fb.vec(op, kOpInputs, 4, n_op_in);
+        const size_t op_out = fb.vec(op, kOpOutputs, 4, n_op_out);
+        if (n_op_in < 2 || n_op_out != 1 || fb.read<int32_t>(op_in) != cur) {
+            std::cerr << "Operator " << k << " is not chained to the previous layer\n"; return false;
+        }
+        // FullyConnectedOptions：fused_activation_function (0)、weights_format (1)
+        int8_t act = kActNone;
+        if (const size_t opt = fb.field(op, kOpOptions)) {
+            const size_t t = fb.deref(opt);
+            act = fb.scalar<int8_t>(t, 0, kActNone);
+            if (fb.scalar<int8_t>(t, 1, 0) != 0) { std::cerr << "Shuffled FullyConnected weights are not supported\n"; return false; }
+        }
+        if (act != kActNone && act != kActRelu) { std::cerr << "Operator " << k << " activation is not NONE/RELU\n"; return false; }
+
+        DenseLayer L;
+        if (!tensor_info(fb.read<int32_t>(op_in + 4), shape, values) || shape.size() != 2) {
+            std::cerr << "Operator " << k << " weights are not a constant float32 matrix\n"; return false;
+        }
+        L.out = shape[0];
+        L.in = shape[1];
+        L.relu = act == kActRelu;
+        if (L.in != width || L.out <= 0 || values.size() != size_t(L.in) * L.out) {
+            std::cerr << "Operator " << k << " weight shape does not match its input\n"; return false;
+        }
+        L.wt.resize(values.size());                           // [out][in] → [in][out]
+        for (int o = 0; o < L.out; ++o)
+            for (int i = 0; i < L.in; ++i) L.wt[size_t(i) * L.out + o] = values[size_t(o) * L.in + i];
+        L.bias.assign(L.out, 0.f);
+        const int32_t bias_idx = n_op_in > 2 ? fb.read<int32_t>(op_in + 8) : -1;
+        if (bias_idx >= 0) {
+            if (!tensor_info(bias_idx, shape, values) || values.size() != size_t(L.out)) {
+                std::cerr << "Operator " << k << " bias does not match its output\n"; return false;
+            }
+            L.bias = values;
+        }
+        layers.push_back(std::move(L));
+        cur = fb.read<int32_t>(op_out);
+        width = layers.back().out;
+    }
+    if (!fb.ok() || cur != fb.read<int32_t>(g_out)) {
+        std::cerr << "Last FullyConnected output is not the graph output\n"; layers.clear(); return false;
+    }
+    return true;
+}
+
+//------------------------------------------------------------
+// GEMV+ReLU 核心：y = act(Wᵀx + b)，IN/OUT 為編譯期常數時迴圈全展開，
+// 累加值留在暫存器，ReLU 在寫回前套用
+//------------------------------------------------------------
+template <int IN, int OUT>
+inline void dense_scalar(const DenseLayer& L, const float* x, float* y) {
+    float acc[OUT];
+    for (int o = 0; o < OUT; ++o) acc[o] = L.bias[o];
+    for (int i = 0; i < IN; ++i) {
+        const float xi = x[i];
+        const float* w = L.wt.data() + i * OUT;
+        for (int o = 0; o < OUT; ++o) acc[o] += xi * w[o];
+    }
+    for (int o = 0; o < OUT; ++o) y[o] = L.relu ? std::max(acc[o], 0.f) : acc[o];
+}
+
+template <int IN, int OUT, int... REST>
+inline void mlp_forward_scalar(const DenseLayer* L, const float* x, float* y) {
+    if constexpr (sizeof...(REST) == 0) {
+        dense_scalar<IN, OUT>(*L, x, y);
+    } else {
+        float h[OUT];
+        dense_scalar<IN, OUT>(*L, x, h);
+        mlp_forward_scalar<OUT, REST...>(L + 1, h, y);
+    }
+}
+
+/* 各指令集的向量操作；x86 的 AVX2 程式碼以 target pragma 編譯，
+ * 基本建置 (無 -mavx2) 仍可在舊 CPU 上執行，由 dnn_simd_available() 決定是否呼叫 */
+#if defined(__x86_64__) || defined(__i386__)
+#define DNN_HAVE_SIMD 1
+#pragma GCC push_options
+#pragma GCC target("avx2,fma")
+struct DnnVecOps {
+    using V = __m256;
+    static constexpr int W = 8;
+    static V load(const float* p)         { return _mm256_loadu_ps(p); }
+    static void store(float* p, V v)      { _mm256_storeu_ps(p, v); }
+    static V set1(float v)                { return _mm256_set1_ps(v); }
+    static V fma(V a, V b, V c)           { return _mm256_fmadd_ps(a, b, c); }
+    static V relu(V v)                    { return _mm256_max_ps(v, _mm256_setzero_ps()); }
+};
+#elif defined(__aarch64__)
+#define DNN_HAVE_SIMD 1
+struct DnnVecOps {
+    using V = float32x4_t;
+    static constexpr int W = 4;
+    static V load(const float* p)         { return vld1q_f32(p); }
+    static void store(float* p, V v)      { vst1q_f32(p, v); }
+    static V set1(float v)                { return vdupq_n_f32(v); }
+    static V fma(V a, V b, V c)           { return vfmaq_f32(c, a, b); }
+    static V relu(V v)                    { return vmaxq_f32(v, vdupq_n_f32(0.f)); }
+};
+#endif
+
+#ifdef DNN_HAVE_SIMD
+// OUT 為 W 的倍數時沿輸出方向向量化 (OUT/W 個累加暫存器)；否則 (如最後 16→1) 以純量點積
+template <int IN, int OUT>
+inline void dense_simd(const DenseLayer& L, const float* x, float* y) {
+    using Ops = DnnVecOps;
+    if constexpr (OUT % Ops::W == 0) {
+        constexpr int R = OUT / Ops::W;
+        typename Ops::V acc[R];
+        for (int r = 0; r < R; ++r) acc[r] = Ops::load(L.bias.data() + r * Ops::W);
+        const float* w = L.wt.data();
+        for (int i = 0; i < IN; ++i, w += OUT) {
+            const typename Ops::V xi = Ops::set1(x[i]);
+            for (int r = 0; r < R; ++r) acc[r] = Ops::fma(xi, Ops::load(w + r * Ops::W), acc[r]);
+        }
+        for (int r = 0; r < R; ++r) Ops::store(y + r * Ops::W, L.relu ? Ops::relu(acc[r]) : acc[r]);
+    } else {
+        float acc[OUT];
+        for (int o = 0; o < OUT; ++o) acc[o] = L.bias[o];
+        for (int i = 0; i < IN; ++i)
+            for (int o = 0; o < OUT; ++o) acc[o] += x[i] * L.wt[size_t(i) * OUT + o];
+        for (int o = 0; o < OUT; ++o) y[o] = L.relu ? std::max(acc[o], 0.f) : acc[o];
+    }
+}
+
+template <int IN, int OUT, int... REST>
+inline void mlp_forward_simd(const DenseLayer* L, const float* x, float* y) {
+    if constexpr (sizeof...(REST) == 0) {
+        dense_simd<IN, OUT>(*L, x, y);
+    } else {
+        alignas(32) float h[OUT];
+        dense_simd<IN, OUT>(*L, x, h);
+        mlp_forward_simd<OUT, REST...>(L + 1, h, y);
+    }
+}
+#endif
+
+#if defined(__x86_64__) || defined(__i386__)
+#pragma GCC pop_options
+#endif
+
+// 執行期偵測：x86 需 AVX2+FMA；aarch64 的 Advanced SIMD 為基本指令集
+inline bool dnn_simd_available() {
+#if defined(__x86_64__) || defined(__i386__)
+    return __builtin_cpu_supports("avx2") && __builtin_cpu_supports("fma");
+#elif defined(__aarch64__)
+    return true;
+#else
+    return false;
+#endif
+}
+
+// 執行期層大小的後備路徑 (任意 FullyConnected 串接)
+inline void mlp_forward_generic(const std::vector<DenseLayer>& layers, const float* x, float* y,
+                                std::vector<float>& a, std::vector<float>& b) {
+    const float* in = x;
+    for (size_t k = 0; k < layers.size(); ++k) {
+        const DenseLayer& L = layers[k];
+        float* out = k + 1 == layers.size() ? y : (k % 2 ? b.data() : a.data());
+        for (int o = 0; o < L.out; ++o) out[o] = L.bias[o];
+        for (int i = 0; i < L.in; ++i)
+            for (int o = 0; o < L.out; ++o) out[o] += in[i] * L.wt[size_t(i) * L.out + o];
+        if (L.relu) for (int o = 0; o < L.out; ++o) out[o] = std::max(out[o], 0.f);
+        in = out;
+    }
+}
+
+//------------------------------------------------------------
+// 原生 MLP：load 後權重複製一份，模型檔 / 緩衝即可釋放；
+// run() 不配置記憶體，同一物件一次只給一個執行緒使用
+//------------------------------------------------------------
+class NativeMlp {
+public:
+    bool load_file(const std::string& path) {
+        std::ifstream f(path, std::ios::binary);
+        if (!f.is_open()) { std::cerr << "Failed to load model: " << path << "\n"; return false; }
+        std::vector<char> buf((std::istreambuf_iterator<char>(f)), std::istreambuf_iterator<char>());
+        return load_buffer(buf.data(), buf.size());
+    }
+
+    bool load_buffer(const char* data, size_t size) {
+        if (!tflite_extract_dense(reinterpret_cast<const uint8_t*>(data), size, layers_)) return false;
+        size_t widest = 0;
+        for (const DenseLayer& L : layers_) widest = std::max(widest, size_t(L.out));
+        scratch_a_.assign(widest, 0.f);
+        scratch_b_.assign(widest, 0.f);
+        pick_kernel();
+        return true;
+    }
+
+    int input_len() const { return layers_.empty() ? 0 : layers_.front().in; }
+    int output_len() const { return layers_.empty() ? 0 : layers_.back().out; }
+    const std::vector<DenseLayer>& layers() const { return layers_; }
+    // 例如 "avx2 10-16-32-16-1" / "scalar generic"
+    const std::string& kernel_name() const { return kernel_name_; }
+
+    // x[input_len] → y[output_len]
+    void run(const float* x, float* y) {
+        if (fixed_) fixed_(layers_.data(), x, y);
+        else mlp_forward_generic(layers_, x, y, scratch_a_, scratch_b_);
+    }
+
+private:
+    using FixedFn = void (*)(const DenseLayer*, const float*, float*);
+
+    template <int... D>
+    bool dims_are() const {
+        constexpr int dims[] = {D...};
+        if (layers_.size() + 1 != sizeof...(D)) return false;
+        for (size_t k = 0; k < layers_.size(); ++k)
+            if (layers_[k].in != dims[k] || layers_[k].out != dims[k + 1]) return false;
+        return true;
+    }
+
+    // 已知拓樸選用編譯期固定大小的核心，其餘走 generic
+    void pick_kernel() {
+        fixed_ = nullptr;
+        kernel_name_ = "scalar generic";
+        const bool simd = dnn_simd_available();
+        if (dims_are<10, 16, 32, 16, 1>()) {
+#ifdef DNN_HAVE_SIMD
+            if (simd) fixed_ = mlp_forward_simd<10, 16, 32, 16, 1>;
+#endif
+            if (!fixed_) fixed_ = mlp_forward_scalar<10, 16, 32, 16, 1>;
+            kernel_name_ = std::string(fixed_ == mlp_forward_scalar<10, 16, 32, 16, 1> ? "scalar" : simd_name())
+                         + " 10-16-32-16-1";
+        }
+    }
+
+    static const char* simd_name() {
+#if defined(__aarch64__)
+        return "neon";
+#else
+        return "avx2";
+#endif
+    }
+
+    std::vector<DenseLayer> layers_;
+    FixedFn fixed_ = nullptr;
+    std::string kernel_name_;
+    std::vector<float> scratch_a_, scratch_b_;
+};
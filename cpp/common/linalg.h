@@ -0,0 +1,47 @@
+#pragma once
+//------------------------------------------------------------
+// 小型稠密線性代數 (header-only)：部分主元 LU 分解與求解，
+// 供 Hannan–Rissanen 正規方程 (arima_fit.h) 與階層調和 (arima_hierarchy.h) 共用
+//------------------------------------------------------------
+#include <cmath>
+#include <cstddef>
+#include <utility>
+#include <vector>
+
+// LU 分解 (部分主元)：A 為 n×n row-major，原地覆寫為 L\U，piv[c] 為第 c 步交換的列
+inline bool lu_factor(double* A, int* piv, int n) {
+    for (int c = 0; c < n; ++c) {
+        int pr = c;
+        for (int r = c + 1; r < n; ++r)
+            if (std::abs(A[size_t(r) * n + c]) > std::abs(A[size_t(pr) * n + c])) pr = r;
+        if (std::abs(A[size_t(pr) * n + c]) < 1e-300) return false;
+        piv[c] = pr;
+        if (pr != c)
+            for (int j = 0; j < n; ++j) std::swap(A[size_t(c) * n + j], A[size_t(pr) * n + j]);
+        for (int r = c + 1; r < n; ++r) {
+            const double f = A[size_t(r) * n + c] /= A[size_t(c) * n + c];
+            for (int j = c + 1; j < n; ++j) A[size_t(r) * n + j] -= f * A[size_t(c) * n + j];
+        }
+    }
+    return true;
+}
+
+// 以 lu_factor() 的結果解 A x = b，解覆寫於 b；同一分解可重複使用
+inline void lu_solve(const double* LU, const int* piv, double* b, int n) {
+    for (int c = 0; c < n; ++c) {
+        if (piv[c] != c) std::swap(b[c], b[piv[c]]);
+        for (int r = c + 1; r < n; ++r) b[r] -= LU[size_t(r) * n + c] * b[c];
+    }
+    for (int r = n - 1; r >= 0; --r) {
+        for (int j = r + 1; j < n; ++j) b[r] -= LU[size_t(r) * n + j] * b[j];
+        b[r] /= LU[size_t(r) * n + r];
+    }
+}
+
+// 單次求解：A 會被覆寫，解覆寫於 b
+inline bool solve_linear(std::vector<double>& A, std::vector<double>& b, int n) {
+    std::vector<int> piv(n);
+    if (!lu_factor(A.data(), piv.data(), n)) return false;
+    lu_solve(A.data(), piv.data(), b.data(), n);
+    return true;
+}
@@ -0,0 +1,27 @@
+#pragma once
+//------------------------------------------------------------
+// 不持有記憶體的連續區段 (C++17 沒有 std::span)：指標 + 長度，
+// 可由 std::vector / std::array 或 (指標, 長度) 建立，供函式庫 API 傳遞呼叫端緩衝
+//------------------------------------------------------------
+#include <cstddef>
+
+template <typename T>
+class Span {
+public:
+    Span() = default;
+    Span(T* data, size_t size) : data_(data), size_(size) {}
+    template <class C>
+    Span(C& c) : data_(c.data()), size_(c.size()) {}
+
+    T* data() const { return data_; }
+    size_t size() const { return size_; }
+    bool empty() const { return size_ == 0; }
+    T& operator[](size_t i) const { return data_[i]; }
+    T* begin() const { return data_; }
+    T* end() const { return data_ + size_; }
+    Span last(size_t n) const { return {data_ + size_ - n, n}; }
+
+private:
+    T* data_ = nullptr;
+    size_t size_ = 0;
+};
@@ -0,0 +1,525 @@
+#pragma once
+//------------------------------------------------------------
+// AR-DNN 預測 / Conv1D 分類的 TFLite 包裝 (header-only)：由兩個 demo 的 main.cpp 抽出，
+// 供資料擷取程序直接嵌入呼叫，不需另起 run_model 子程序。
+//   模型物件  : TfliteModel      ‒ load_file() / load_buffer() 一次建好直譯器與張量，
+//               TfliteOptions 指定委派 (default / xnnpack / none) 與執行緒數
+//   預測器物件: ArDnnForecaster  ‒ forecast(history, out)，out.size() 即預測步數；
+//               可改接 NativeMlp (dnn_native.h) 略過直譯器
+//   批次預測  : ArDnnBatchForecaster ‒ N 條序列同步推進，每步一次 Invoke (輸入 [N, window])
+//   分類器物件: Conv1dClassifier ‒ classify(series, probs)，回傳類別
+// 呼叫時只讀寫呼叫端緩衝，不做檔案 I/O 或字串解析；同一個 TfliteModel 一次只給一個物件使用
+//
+// 以 -DTFLITE_MINIMAL_OPS 編譯時 (靜態連結版)，呼叫端須先 include 由 gen_op_resolver.py 產生的
+// *_op_resolver.h，直譯器改用其中的 MinimalOpResolver，只連進模型用到的 kernel
+//------------------------------------------------------------
+#include "tensorflow/lite/delegates/xnnpack/xnnpack_delegate.h"
+#include "tensorflow/lite/interpreter.h"
+#include "tensorflow/lite/model.h"
+#ifndef TFLITE_MINIMAL_OPS
+#include "tensorflow/lite/kernels/register.h"
+#endif
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <fstream>
+#include <functional>
+#include <iostream>
+#include <sstream>
+#include <limits>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "dnn_native.h"
+#include "span.h"
+
+// float → int8 (依張量的 scale / zero_point，超出範圍時飽和)
+inline int8_t tflite_quantize(float v, const TfLiteTensor* t) {
+    int32_t q = static_cast<int32_t>(std::round(v / t->params.scale) + t->params.zero_point);
+    q = std::min<int32_t>(std::max<int32_t>(q, std::numeric_limits<int8_t>::min()), std::numeric_limits<int8_t>::max());
+    return static_cast<int8_t>(q);
+}
+
+inline float tflite_dequantize(int8_t q, const TfLiteTensor* t) {
+    return (static_cast<int32_t>(q) - t->params.zero_point) * t->params.scale;
+}
+
+//------------------------------------------------------------
+// 直譯器設定
+//   Default : BuiltinOpResolver，TFLite 自行套用預設委派 (以 XNNPACK 編譯時即為 XNNPACK)；
+//             TFLITE_MINIMAL_OPS 版沒有預設委派，改為明確套用 XNNPACK (同 Xnnpack)
+//   Xnnpack : 明確建立 XNNPACK 委派，執行緒數交給委派
+//   None    : 不套用任何委派，只用內建 kernel
+//------------------------------------------------------------
+enum class TfliteDelegate { Default, Xnnpack, None };
+
+inline const char* tflite_delegate_name(TfliteDelegate d) {
+    switch (d) {
+        case TfliteDelegate::Xnnpack: return "xnnpack";
+        case TfliteDelegate::None:    return "none";
+        default:                      return "default";
+    }
+}
+
+inline bool parse_tflite_delegate(const std::string& s, TfliteDelegate& d) {
+    if (s == "default")      d = TfliteDelegate::Default;
+    else if (s == "xnnpack") d = TfliteDelegate::Xnnpack;
+    else if (s == "none")    d = TfliteDelegate::None;
+    else return false;
+    return true;
+}
+
+struct TfliteOptions {
+    TfliteDelegate delegate = TfliteDelegate::Default;
+    int threads = -1;                   // ≤ 0：TFLite 預設
+};
+
+/* 讀取 --autotune 寫出的設定檔 (key,value 格式同 *-std-mean.csv)；
+ * 只覆寫檔案中有的欄位，檔案不存在回傳 false */
+inline bool read_tflite_options(const std::string& path, TfliteOptions& opts) {
+    std::ifstream file(path);
+    if (!file.is_open()) return false;
+    std::string line;
+    while (std::getline(file, line)) {
+        std::stringstream ss(line);
+        std::string key, val;
+        if (!std::getline(ss, key, ',') || !std::getline(ss, val)) continue;
+        if (!val.empty() && val.back() == '\r') val.pop_back();
+        if (key == "delegate" && !parse_tflite_delegate(val, opts.delegate))
+            std::cerr << "Unknown delegate in " << path << ": " << val << "\n";
+        else if (key == "threads")
+            opts.threads = std::atoi(val.c_str());
+    }
+    return true;
+}
+
+// 預設設定檔路徑：模型檔名去掉 .tflite 後加 -tune.csv (與 *-std-mean.csv 同一命名方式)
+inline std::string tflite_tune_path(const std::string& model_path) {
+    const std::string ext = ".tflite";
+    const bool has_ext = model_path.size() >= ext.size() &&
+                         model_path.compare(model_path.size() - ext.size(), ext.size(), ext) == 0;
+    return (has_ext ? model_path.substr(0, model_path.size() - ext.size()) : model_path) + "-tune.csv";
+}
+
+inline bool write_tflite_options(const std::string& path, const TfliteOptions& opts,
+                                 const std::string& input_shape, double us_per_invoke) {
+    std::ofstream file(path);
+    if (!file.is_open()) { std::cerr << "Cannot write tune file: " << path << "\n"; return false; }
+    file << "delegate," << tflite_delegate_name(opts.delegate) << "\n"
+         << "threads," << opts.threads << "\n"
+         << "input_shape," << input_shape << "\n"
+         << "us_per_invoke," << us_per_invoke << "\n";
+    return true;
+}
+
+// 一個 .tflite 模型與其直譯器 (張量已配置)；不可複製
+class TfliteModel {
+public:
+    TfliteModel() = default;
+    TfliteModel(const TfliteModel&) = delete;
+    TfliteModel& operator=(const TfliteModel&) = delete;
+
+    bool load_file(const std::string& path, const TfliteOptions& opts = {}) {
+        model_ = tflite::FlatBufferModel::BuildFromFile(path.c_str());
+        if (!model_) { std::cerr << "Failed to load model: " << path << "\n"; return false; }
+        return configure(opts);
+    }
+
+    // data 須在模型存活期間保持有效 (例如韌體內嵌的陣列或程序自己 mmap 的檔案)
+    bool load_buffer(const char* data, size_t size, const TfliteOptions& opts = {}) {
+        model_ = tflite::FlatBufferModel::BuildFromBuffer(data, size);
+        if (!model_) { std::cerr << "Failed to load model from buffer\n"; return false; }
+        return configure(opts);
+    }
+
+    // 以新設定重建直譯器 (輸入形狀回到模型原始形狀，之前取得的張量指標全部失效)
+    bool configure(const TfliteOptions& opts) {
+        options_ = opts;
+        interpreter_.reset();                   // 直譯器須先於委派釋放
+        delegate_.reset();
+        return build();
+    }
+
+    const TfliteOptions& options() const { return options_; }
+    tflite::Interpreter* interpreter() const { return interpreter_.get(); }
+    int input_index() const { return interpreter_->inputs()[0]; }
+    int output_index() const { return interpreter_->outputs()[0]; }
+    TfLiteTensor* input() const { return interpreter_->tensor(input_index()); }
+    TfLiteTensor* output() const { return interpreter_->tensor(output_index()); }
+
+    // 改變輸入張量形狀並重新配置；之前取得的張量資料指標全部失效
+    bool resize_input(const std::vector<int>& dims) {
+        if (interpreter_->ResizeInputTensor(input_index(), dims) != kTfLiteOk) { std::cerr << "ResizeInputTensor failed\n"; return false; }
+        if (interpreter_->AllocateTensors() != kTfLiteOk) { std::cerr << "AllocateTensors failed\n"; return false; }
+        return true;
+    }
+
+private:
+    bool build() {
+#ifdef TFLITE_MINIMAL_OPS
+        MinimalOpResolver resolver;
+        build_interpreter(resolver);
+        const bool xnnpack = options_.delegate != TfliteDelegate::None;
+#else
+        // Default 之外不讓 resolver 帶入 TFLite 的預設委派
+        if (options_.delegate == TfliteDelegate::Default) {
+            tflite::ops::builtin::BuiltinOpResolver resolver;
+            build_interpreter(resolver);
+        } else {
+            tflite::ops::builtin::BuiltinOpResolverWithoutDefaultDelegates resolver;
+            build_interpreter(resolver);
+        }
+        const bool xnnpack = options_.delegate == TfliteDelegate::Xnnpack;
+#endif
+        if (!interpreter_) { std::cerr << "Failed to construct interpreter\n"; return false; }
+        if (xnnpack) {
+            TfLiteXNNPackDelegateOptions xnn = TfLiteXNNPackDelegateOptionsDefault();
+            if (options_.threads > 0) xnn.num_threads = options_.threads;
+            delegate_.reset(TfLiteXNNPackDelegateCreate(&xnn));
+            if (!delegate_ || interpreter_->ModifyGraphWithDelegate(delegate_.get()) != kTfLiteOk) {
+                std::cerr << "Failed to apply the XNNPACK delegate\n"; return false;
+            }
+        }
+        if (interpreter_->AllocateTensors() != kTfLiteOk) { std::cerr << "AllocateTensors failed\n"; return false; }
+        return true;
+    }
+
+    void build_interpreter(const tflite::OpResolver& resolver) {
+        tflite::InterpreterBuilder builder(*model_, resolver);
+        if (options_.threads > 0) builder.SetNumThreads(options_.threads);
+        builder(&interpreter_);
+    }
+
+    // 釋放順序與宣告相反：直譯器 → 委派 → 模型
+    std::unique_ptr<tflite::FlatBufferModel> model_;
+    std::unique_ptr<TfLiteDelegate, void (*)(TfLiteDelegate*)> delegate_{nullptr, TfLiteXNNPackDelegateDelete};
+    std::unique_ptr<tflite::Interpreter> interpreter_;
+    TfliteOptions options_;
+};
+
+struct TfliteTuneResult {
+    TfliteOptions options;
+    double us_per_invoke = 0.0;
+};
+
+/* --autotune：每個 (委派, 執行緒數) 組合各重建一次直譯器，prepare(model) 設定輸入形狀與內容後
+ * 重複 Invoke 至少 min_sec 秒。threads 為 1, 2, 4, … max_threads (含 max_threads)。
+ * 結果依耗時由快到慢排序；結束時模型以最快的組合重建 (prepare 也會再呼叫一次) */
+inline bool tflite_autotune(TfliteModel& model, const std::function<bool(TfliteModel&)>& prepare,
+                            int max_threads, std::vector<TfliteTuneResult>& results, double min_sec = 0.2) {
+    std::vector<int> threads;
+    for (int t = 1; t < max_threads; t *= 2) threads.push_back(t);
+    threads.push_back(std::max(max_threads, 1));
+    results.clear();
+    for (TfliteDelegate d : {TfliteDelegate::Default, TfliteDelegate::Xnnpack, TfliteDelegate::None}) {
+        for (int t : threads) {
+            TfliteOptions opts{d, t};
+            if (!model.configure(opts) || !prepare(model)) {
+                std::cerr << "Skipping delegate=" << tflite_delegate_name(d) << " threads=" << t << "\n";
+                continue;
+            }
+            tflite::Interpreter* interpreter = model.interpreter();
+            if (interpreter->Invoke() != kTfLiteOk) continue;       // 暖機 (委派在首次 Invoke 準備)
+            size_t reps = 0;
+            const auto t0 = std::chrono::steady_clock::now();
+            double sec = 0.0;
+            do {
+                if (interpreter->Invoke() != kTfLiteOk) break;
+                ++reps;
+                sec = std::chrono::duration<double>(std::chrono::steady_clock::now() - t0).count();
+            } while (sec < min_sec || reps < 3);
+            if (reps) results.push_back({opts, sec / reps * 1e6});
+        }
+    }
+    if (results.empty()) { std::cerr << "No TFLite configuration could run\n"; return false; }
+    std::stable_sort(results.begin(), results.end(),
+                     [](const TfliteTuneResult& a, const TfliteTuneResult& b) { return a.us_per_invoke < b.us_per_invoke; });
+    return model.configure(results[0].options) && prepare(model);
+}
+
+/* 鏡像環形緩衝：長度 2·len，每個值同時寫在 i 與 i+len，
+ * 因此最近 len 個值 (由舊到新) 永遠是連續的 data() ~ data()+len，推入新值 O(1) */
+template <typename T>
+class MirrorRing {
+public:
+    void reset(int len) { len_ = len; head_ = 0; buf_.assign(size_t(2) * len, T(0)); }
+    void push(T v) {
+        buf_[head_] = v;
+        buf_[head_ + len_] = v;
+        head_ = head_ + 1 == len_ ? 0 : head_ + 1;     // head_ 指向最舊值
+    }
+    const T* data() const { return buf_.data() + head_; }
+
+private:
+    std::vector<T> buf_;
+    int len_ = 0, head_ = 0;
+};
+
+//------------------------------------------------------------
+// AR-DNN 自迴歸預測：以 history 最後 input_len 個值 (原始尺度) 為窗口，
+// 標準化一次後放進環形緩衝；每步只推入模型輸出的標準化預測值，輸出時才反標準化。
+// 推理引擎為 TFLite 直譯器或原生 MLP (NativeMlp)，依 init 的多載決定。
+// TFLite 的張量指標在 init 時取得一次，之後不可再對該模型 ResizeInputTensor / AllocateTensors
+//------------------------------------------------------------
+class ArDnnForecaster {
+public:
+    bool init(TfliteModel& model, float mean, float std) {
+        TfLiteTensor* in = model.input();
+        if (in->dims->size < 1) { std::cerr << "Invalid input tensor dims\n"; return false; }
+        if (in->type != kTfLiteFloat32 && in->type != kTfLiteInt8) { std::cerr << "Unsupported input tensor type\n"; return false; }
+        TfLiteTensor* out = model.output();
+        if (out->type != kTfLiteFloat32 && out->type != kTfLiteInt8) { std::cerr << "Unsupported output tensor type\n"; return false; }
+        if (!init_common(in->dims->data[in->dims->size - 1], mean, std)) return false;
+        model_ = &model;
+        native_ = nullptr;
+        tflite::Interpreter* interpreter = model.interpreter();
+        in_tensor_ = in;
+        out_tensor_ = out;
+        in_f32_ = in->type == kTfLiteFloat32 ? interpreter->typed_tensor<float>(model.input_index()) : nullptr;
+        in_i8_ = in->type == kTfLiteInt8 ? interpreter->typed_tensor<int8_t>(model.input_index()) : nullptr;
+        out_f32_ = out->type == kTfLiteFloat32 ? interpreter->typed_tensor<float>(model.output_index()) : nullptr;
+        out_i8_ = out->type == kTfLiteInt8 ? interpreter->typed_tensor<int8_t>(model.output_index()) : nullptr;
+        return true;
+    }
+
+    bool init(NativeMlp& mlp, float mean, float std) {
+        if (mlp.output_len() != 1) { std::cerr << "Native model must have a single output\n"; return false; }
+        if (!init_common(mlp.input_len(), mean, std)) return false;
+        native_ = &mlp;
+        model_ = nullptr;
+        return true;
+    }
+
+    int input_len() const { return input_len_; }
+    bool is_native() const { return native_ != nullptr; }
+
+    // history.size() ≥ input_len；預測 out.size() 步寫入 out
+    bool forecast(Span<const float> history, Span<float> out) {
+        if (history.size() < size_t(input_len_)) {
+            std::cerr << "History size (" << history.size() << ") is smaller than input_len (" << input_len_ << ")\n";
+            return false;
+        }
+        // 1) 窗口只在開始時標準化一次 (int8 模型同時量化)
+        for (const float v : history.last(input_len_)) {
+            const float z = (v - mean_) / std_;
+            if (in_i8_) ring_i8_.push(tflite_quantize(z, in_tensor_));
+            else ring_.push(z);
+        }
+
+        for (size_t step = 0; step < out.size(); ++step) {
+            // 2) 推理：原生 MLP 直接讀環形緩衝；TFLite 把連續的窗口複製進輸入張量
+            float pred_std = 0.f;
+            if (native_) {
+                native_->run(ring_.data(), &pred_std);
+            } else {
+                if (in_f32_) std::copy(ring_.data(), ring_.data() + input_len_, in_f32_);
+                else std::copy(ring_i8_.data(), ring_i8_.data() + input_len_, in_i8_);
+                if (model_->interpreter()->Invoke() != kTfLiteOk) { std::cerr << "Inference failed\n"; return false; }
+                pred_std = out_f32_ ? out_f32_[0] : tflite_dequantize(out_i8_[0], out_tensor_);
+            }
+
+            // 3) 反標準化輸出；推入窗口的是標準化值，不需再標準化
+            out[step] = pred_std * std_ + mean_;
+            if (in_i8_) ring_i8_.push(tflite_quantize(pred_std, in_tensor_));
+            else ring_.push(pred_std);
+        }
+        return true;
+    }
+
+private:
+    bool init_common(int input_len, float mean, float std) {
+        if (std == 0.f) { std::cerr << "std in stats file must not be 0\n"; return false; }
+        if (input_len <= 0) { std::cerr << "Input length must be > 0\n"; return false; }
+        mean_ = mean;
+        std_ = std;
+        input_len_ = input_len;
+        ring_.reset(input_len_);
+        ring_i8_.reset(input_len_);
+        in_tensor_ = out_tensor_ = nullptr;
+        in_f32_ = nullptr;
+        in_i8_ = nullptr;
+        out_f32_ = nullptr;
+        out_i8_ = nullptr;
+        return true;
+    }
+
+    TfliteModel* model_ = nullptr;
+    NativeMlp* native_ = nullptr;
+    float mean_ = 0.f, std_ = 1.f;
+    int input_len_ = 0;
+    MirrorRing<float> ring_;            // 標準化後的窗口 (float 模型 / 原生 MLP)
+    MirrorRing<int8_t> ring_i8_;        // 量化後的窗口 (int8 模型)
+    // init 時解析一次的張量與資料指標
+    const TfLiteTensor* in_tensor_ = nullptr;
+    const TfLiteTensor* out_tensor_ = nullptr;
+    float* in_f32_ = nullptr;
+    int8_t* in_i8_ = nullptr;
+    const float* out_f32_ = nullptr;
+    const int8_t* out_i8_ = nullptr;
+};
+
+//------------------------------------------------------------
+// AR-DNN 批次自迴歸預測：N 條序列 (例如每台風機一條) 共用模型與標準化參數，
+// 輸入張量改為 [N, input_len]，每步一次 Invoke 同時推進全部序列。
+// 原生 MLP 則每步對 N 條序列各跑一次 (無直譯器開銷，不需 resize)。
+// init 會 resize 模型的輸入張量，同一個 TfliteModel 之後不可再給 ArDnnForecaster 使用
+//------------------------------------------------------------
+class ArDnnBatchForecaster {
+public:
+    bool init(TfliteModel& model, int n_series, float mean, float std) {
+        const TfLiteTensor* in = model.input();
+        if (in->dims->size != 2) { std::cerr << "Batch mode needs a [batch, window] input tensor\n"; return false; }
+        if (in->type != kTfLiteFloat32 || model.output()->type != kTfLiteFloat32) {
+            std::cerr << "Batch mode supports float32 models only\n"; return false;
+        }
+        const int input_len = in->dims->data[1];
+        if (!init_common(n_series, input_len, mean, std)) return false;
+        if (!model.resize_input({n_series, input_len})) return false;
+        const TfLiteTensor* out = model.output();
+        if (out->dims->size < 1 || out->dims->data[0] != n_series || out->bytes != n_series * sizeof(float)) {
+            std::cerr << "Output tensor is not [" << n_series << ", 1] after resizing\n"; return false;
+        }
+        model_ = &model;
+        native_ = nullptr;
+        in_f32_ = model.interpreter()->typed_tensor<float>(model.input_index());
+        out_f32_ = model.interpreter()->typed_tensor<float>(model.output_index());
+        return true;
+    }
+
+    bool init(NativeMlp& mlp, int n_series, float mean, float std) {
+        if (mlp.output_len() != 1) { std::cerr << "Native model must have a single output\n"; return false; }
+        if (!init_common(n_series, mlp.input_len(), mean, std)) return false;
+        native_ = &mlp;
+        model_ = nullptr;
+        return true;
+    }
+
+    int input_len() const { return input_len_; }
+    int n_series() const { return n_; }
+
+    /* histories[s].size() ≥ input_len；out 佈局為 [step][series]，
+     * 預測步數 = out.size() / n_series */
+    bool forecast(const std::vector<Span<const float>>& histories, Span<float> out) {
+        if (histories.size() != size_t(n_)) { std::cerr << "Expected " << n_ << " series, got " << histories.size() << "\n"; return false; }
+        for (int s = 0; s < n_; ++s) {
+            if (histories[s].size() < size_t(input_len_)) {
+                std::cerr << "History " << s << " size (" << histories[s].size() << ") is smaller than input_len (" << input_len_ << ")\n";
+                return false;
+            }
+            for (const float v : histories[s].last(input_len_)) rings_[s].push((v - mean_) / std_);
+        }
+
+        const size_t n_steps = out.size() / size_t(n_);
+        for (size_t step = 0; step < n_steps; ++step) {
+            float* row = out.begin() + step * n_;
+            if (native_) {
+                for (int s = 0; s < n_; ++s) native_->run(rings_[s].data(), &pred_std_[s]);
+            } else {
+                for (int s = 0; s < n_; ++s)
+                    std::copy(rings_[s].data(), rings_[s].data() + input_len_, in_f32_ + size_t(s) * input_len_);
+                if (model_->interpreter()->Invoke() != kTfLiteOk) { std::cerr << "Inference failed\n"; return false; }
+                std::copy(out_f32_, out_f32_ + n_, pred_std_.begin());
+            }
+            for (int s = 0; s < n_; ++s) {
+                row[s] = pred_std_[s] * std_ + mean_;
+                rings_[s].push(pred_std_[s]);
+            }
+        }
+        return true;
+    }
+
+private:
+    bool init_common(int n_series, int input_len, float mean, float std) {
+        if (std == 0.f) { std::cerr << "std in stats file must not be 0\n"; return false; }
+        if (n_series <= 0) { std::cerr << "Batch size must be > 0\n"; return false; }
+        if (input_len <= 0) { std::cerr << "Input length must be > 0\n"; return false; }
+        n_ = n_series;
+        input_len_ = input_len;
+        mean_ = mean;
+        std_ = std;
+        rings_.assign(n_, MirrorRing<float>());
+        for (auto& r : rings_) r.reset(input_len_);
+        pred_std_.assign(n_, 0.f);
+        in_f32_ = nullptr;
+        out_f32_ = nullptr;
+        return true;
+    }
+
+    TfliteModel* model_ = nullptr;
+    NativeMlp* native_ = nullptr;
+    float mean_ = 0.f, std_ = 1.f;
+    int n_ = 0, input_len_ = 0;
+    std::vector<MirrorRing<float>> rings_;      // 各序列標準化後的窗口
+    std::vector<float> pred_std_;               // 本步各序列的標準化預測
+    float* in_f32_ = nullptr;
+    const float* out_f32_ = nullptr;
+};
+
+//------------------------------------------------------------
+// Conv1D 時序分類：輸入長度須等於模型的時間維度，輸出各類 softmax 機率
+//------------------------------------------------------------
+class Conv1dClassifier {
+public:
+    bool init(TfliteModel& model) {
+        model_ = &model;
+        const TfLiteTensor* in = model.input();
+        if (in->type != kTfLiteFloat32 && in->type != kTfLiteInt8) {
+            std::cerr << "Only float32 / int8 input supported\n"; return false;
+        }
+        if (in->dims->size < 2) { std::cerr << "Invalid input tensor dims\n"; return false; }
+        time_dim_ = in->dims->data[in->dims->size - 2];     // 模型的時間維度 (通常 500)
+        const TfLiteTensor* out = model.output();
+        num_classes_ = out->dims->data[out->dims->size - 1];
+        if (out->type != kTfLiteFloat32 && out->type != kTfLiteInt8) { std::cerr << "Unsupported output type\n"; return false; }
+        return true;
+    }
+
+    int time_dim() const { return time_dim_; }
+    int num_classes() const { return num_classes_; }
+
+    /* series.size() == time_dim；probs (長度 ≥ num_classes) 寫入各類機率。
+     * 回傳機率最大的類別，失敗回傳 -1 */
+    int classify(Span<const float> series, Span<float> probs) {
+        if (series.size() != size_t(time_dim_)) {
+            std::cerr << "CSV length (" << series.size() << ") != model time dimension (" << time_dim_ << ")\n";
+            return -1;
+        }
+        if (probs.size() < size_t(num_classes_)) { std::cerr << "probs buffer is smaller than " << num_classes_ << "\n"; return -1; }
+        tflite::Interpreter* interpreter = model_->interpreter();
+        const int in_idx = model_->input_index();
+        TfLiteTensor* in_tensor = model_->input();
+
+        // 寫入 Tensor
+        if (in_tensor->type == kTfLiteFloat32) {
+            float* in = interpreter->typed_tensor<float>(in_idx);
+            std::copy(series.begin(), series.end(), in);
+        } else { // int8 量化
+            int8_t* in = interpreter->typed_tensor<int8_t>(in_idx);
+            for (int t = 0; t < time_dim_; ++t) in[t] = tflite_quantize(series[t], in_tensor);
+        }
+
+        if (interpreter->Invoke() != kTfLiteOk) { std::cerr << "Invoke failed\n"; return -1; }
+
+        // 解析輸出，找最大 softmax 機率
+        const int out_idx = model_->output_index();
+        TfLiteTensor* out_tensor = model_->output();
+        if (out_tensor->type == kTfLiteFloat32) {
+            const float* out = interpreter->typed_tensor<float>(out_idx);
+            std::copy(out, out + num_classes_, probs.begin());
+        } else {
+            const int8_t* out = interpreter->typed_tensor<int8_t>(out_idx);
+            for (int i = 0; i < num_classes_; ++i) probs[i] = tflite_dequantize(out[i], out_tensor);
+        }
+        int pred_class = 0;
+        for (int i = 1; i < num_classes_; ++i)
+            if (probs[i] > probs[pred_class]) pred_class = i;
+        return pred_class;
+    }
+
+private:
+    TfliteModel* model_ = nullptr;
+    int time_dim_ = 0, num_classes_ = 0;
+};
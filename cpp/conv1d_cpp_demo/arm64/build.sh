@@ -15,6 +15,20 @@ DEST_LIB_DIR=${BUILD_DIR}/lib
 TFLITE_BUILD_DIR="$HOME/tensorflow/build_aarch64"
 
 echo "You select $MACHINE"
+
+# ./build.sh static：只建 run_model_static (最小 op resolver、靜態連結 TFLite) 到 build_aarch64_static，
+# 不需複製 .so。TFLite 需先以 -DBUILD_SHARED_LIBS=OFF 建到 $HOME/tensorflow/build_aarch64_static
+if [ "$1" == "static" ]; then
+    BUILD_DIR=build_aarch64_static
+    echo "Start static build $MACHINE on $BUILD_DIR folder"
+    rm -rf "${BUILD_DIR}"
+    cmake -S . -B "${BUILD_DIR}" -DCMAKE_BUILD_TYPE=Release -DBUILD_STATIC=ON
+    cmake --build "${BUILD_DIR}" --target run_model_static -j"$(nproc)"
+    cp ./*.tflite ./sample_idx_*.csv "${BUILD_DIR}"
+    echo "✔ 靜態版完成 → ${BUILD_DIR}/run_model_static (部署時不需 lib/*.so)"
+    exit 0
+fi
+
 echo "Start build $MACHINE on $BUILD_DIR folder"
 
 rm -rf "${BUILD_DIR}" && mkdir ${BUILD_DIR} && mkdir "${DEST_LIB_DIR}"
@@ -34,4 +48,4 @@ cp "${SRC_LIB_DIR}"/*.so "${DEST_LIB_DIR}"
 cp ./*.tflite ./sample_idx_*.csv "${BUILD_DIR}"
 
 echo "✔ 交叉編譯完成 → ${BUILD_DIR}/run_model"
-echo "✔ 依賴 .so 已複製至 ${DEST_LIB_DIR}，執行檔會在 ./lib 找到它們"
\ No newline at end of file
+echo "✔ 依賴 .so 已複製至 ${DEST_LIB_DIR}，執行檔會在 ./lib 找到它們"
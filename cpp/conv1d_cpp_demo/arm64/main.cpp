@@ -1,9 +1,5 @@
 // cls_infer.cpp  ── 1-D CNN 時序分類 TFLite 推論
 // 讀取 CSV，如超出模型需求長度(500)時，自動取最後 500 點
-#include "tensorflow/lite/interpreter.h"
-#include "tensorflow/lite/kernels/register.h"
-#include "tensorflow/lite/model.h"
-
 #include <iostream>
 #include <fstream>
 #include <vector>
@@ -11,19 +7,24 @@
 #include <limits>
 #include <memory>
 #include <cmath>
+#include <thread>
+#include <chrono>
+#include <sys/resource.h>
+
+#include "../../common/csv_reader.h"
+#ifdef TFLITE_MINIMAL_OPS
+#include "../../common/conv1d_op_resolver.h"   // 靜態連結版：只註冊模型用到的 op
+#endif
+#include "../../common/tflite_models.h"
 
 /*********************
  *  CSV utilities    *
  *********************/
 std::vector<float> read_csv(const std::string& path) {
     std::vector<float> data;
-    std::ifstream f(path);
-    if (!f.is_open()) { std::cerr << "Cannot open CSV: " << path << "\n"; std::exit(1); }
-    std::string line;
-    while (std::getline(f, line)) {
-        try { data.push_back(std::stof(line)); }
-        catch (...) { std::cerr << "Bad value in CSV: " << line << "\n"; }
-    }
+    CsvStats st;
+    if (!csv_read_column(path, data, CsvOptions{}, &st)) { std::cerr << "Cannot open CSV: " << path << "\n"; std::exit(1); }
+    if (st.invalid) std::cerr << "Bad values in CSV: " << st.invalid << " line(s) skipped\n";
     return data;
 }
 
@@ -33,11 +34,60 @@ void write_csv(const std::string& path, int cls, float prob) {
     f << cls << ", " << prob << '\n';
 }
 
+/* --autotune：在模型的輸入形狀上量測每個 (委派, 執行緒數) 組合的 Invoke 耗時，
+ * 輸入為 series 最後 time_dim 點 (不足補 0)；最快的組合寫入 tune_path */
+int run_autotune(TfliteModel& model, const std::vector<float>& series, const std::string& tune_path) {
+    auto prepare = [&](TfliteModel& m) -> bool {
+        TfLiteTensor* t = m.input();
+        const int time_dim = t->dims->data[t->dims->size - 2];
+        for (int j = 0; j < time_dim; ++j) {
+            const int k = int(series.size()) - time_dim + j;
+            const float v = k >= 0 ? series[k] : 0.f;
+            if (t->type == kTfLiteFloat32) m.interpreter()->typed_tensor<float>(m.input_index())[j] = v;
+            else m.interpreter()->typed_tensor<int8_t>(m.input_index())[j] = tflite_quantize(v, t);
+        }
+        return true;
+    };
+    std::vector<TfliteTuneResult> results;
+    if (!tflite_autotune(model, prepare, int(std::max(1u, std::thread::hardware_concurrency())), results)) return 1;
+
+    const TfLiteTensor* t = model.input();
+    std::string shape;
+    for (int k = 0; k < t->dims->size; ++k) shape += (k ? "x" : "") + std::to_string(t->dims->data[k]);
+    std::cout << "input shape: " << shape << "\ndelegate,threads,us_per_invoke\n";
+    for (const TfliteTuneResult& r : results)
+        std::cout << tflite_delegate_name(r.options.delegate) << "," << r.options.threads << "," << r.us_per_invoke << "\n";
+    if (!write_tflite_options(tune_path, results[0].options, shape, results[0].us_per_invoke)) return 1;
+    std::cout << "Fastest: delegate=" << tflite_delegate_name(results[0].options.delegate)
+              << ", threads=" << results[0].options.threads << " → saved to " << tune_path << '\n';
+    return 0;
+}
+
+/* --startup-report：程序從 main 開始到輸出完成的時間與峰值 RSS，
+ * 供 cpp/tools/startup_report.sh 比較動態連結與靜態連結 (最小 op resolver) 版 */
+void print_startup_report(std::chrono::steady_clock::time_point t_main) {
+    struct rusage ru{};
+    getrusage(RUSAGE_SELF, &ru);
+    const double ms = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t_main).count();
+#ifdef TFLITE_MINIMAL_OPS
+    const char* resolver = "minimal";
+#else
+    const char* resolver = "builtin";
+#endif
+    std::cout << "startup_report: resolver=" << resolver << ", main_ms=" << ms
+              << ", peak_rss_kb=" << ru.ru_maxrss << '\n';
+}
+
 /*********************
  *  Main             *
  *********************/
 int main(int argc, char* argv[]) {
+    const auto t_main = std::chrono::steady_clock::now();
     std::string model_path, input_path, output_path;
+    std::string delegate_arg, tune_path;
+    int threads = 0;
+    bool autotune = false;
+    bool startup_report = false;
     for (int i = 1; i < argc; ++i) {
         std::string arg = argv[i];
         auto next = [&](const std::string& flag) {
@@ -50,11 +100,31 @@ int main(int argc, char* argv[]) {
         else if (arg.rfind("--model=",0)==0)      model_path  = arg.substr(8);
         else if (arg.rfind("--input=",0)==0)      input_path  = arg.substr(8);
         else if (arg.rfind("--output=",0)==0)     output_path = arg.substr(9);
+        else if (arg.rfind("--delegate=",0)==0)   delegate_arg = arg.substr(11);
+        else if (arg.rfind("--threads=",0)==0)    threads     = std::stoi(arg.substr(10));
+        else if (arg == "--autotune")             autotune    = true;
+        else if (arg.rfind("--tune-file=",0)==0)  tune_path   = arg.substr(12);
+        else if (arg == "--startup-report")       startup_report = true;
     }
     if (model_path.empty() || input_path.empty() || output_path.empty()) {
-        std::cerr << "Usage: ./cls_infer -m model.tflite -i sample.csv -o result.csv\n";
+        std::cerr << "Usage: ./cls_infer -m model.tflite -i sample.csv -o result.csv\n"
+                     "       [--delegate=default|xnnpack|none --threads=N]\n"
+                     "       [--autotune] times every setting and saves the fastest to --tune-file (default <model>-tune.csv)\n"
+                     "       [--startup-report] prints time from main() to done and peak RSS\n";
+        return 1;
+    }
+
+    // TFLite 設定：先讀 --autotune 存下的設定檔，命令列參數再覆寫
+    TfliteOptions tfl_opts;
+    if (tune_path.empty()) tune_path = tflite_tune_path(model_path);
+    const bool tuned = !autotune && read_tflite_options(tune_path, tfl_opts);
+    if (!delegate_arg.empty() && !parse_tflite_delegate(delegate_arg, tfl_opts.delegate)) {
+        std::cerr << "--delegate must be default, xnnpack or none\n";
         return 1;
     }
+    if (threads > 0) tfl_opts.threads = threads;
+    std::cout << "TFLite      : delegate=" << tflite_delegate_name(tfl_opts.delegate) << ", threads=" << tfl_opts.threads
+              << (tuned ? " (from " + tune_path + ")" : std::string()) << '\n';
 
     /* ------------------------------------------------------------- *
      * 1) 讀取資料                                                    *
@@ -64,27 +134,17 @@ int main(int argc, char* argv[]) {
     /* ------------------------------------------------------------- *
      * 2) 載入 TFLite 模型                                           *
      * ------------------------------------------------------------- */
-    auto model = tflite::FlatBufferModel::BuildFromFile(model_path.c_str());
-    if (!model) { std::cerr << "Load model failed\n"; return 1; }
-
-    tflite::ops::builtin::BuiltinOpResolver resolver;
-    std::unique_ptr<tflite::Interpreter> interpreter;
-    tflite::InterpreterBuilder(*model, resolver)(&interpreter);
-    if (!interpreter) { std::cerr << "Create interpreter failed\n"; return 1; }
-    if (interpreter->AllocateTensors() != kTfLiteOk) { std::cerr << "AllocateTensors failed\n"; return 1; }
+    TfliteModel model;
+    if (!model.load_file(model_path, tfl_opts)) return 1;
+    if (autotune) return run_autotune(model, series, tune_path);
+    Conv1dClassifier classifier;
+    if (!classifier.init(model)) return 1;
 
     /* ------------------------------------------------------------- *
      * 3) 準備輸入                                                    *
      * ------------------------------------------------------------- */
-    const int in_idx = interpreter->inputs()[0];
-    TfLiteTensor* in_tensor = interpreter->tensor(in_idx);
-
-    if (in_tensor->type != kTfLiteFloat32 && in_tensor->type != kTfLiteInt8) {
-        std::cerr << "Only float32 / int8 input supported\n"; return 1;
-    }
-
     // 模型的時間維度 (通常 500)
-    int time_dim = in_tensor->dims->data[in_tensor->dims->size - 2];
+    const int time_dim = classifier.time_dim();
 
     // 若資料過長 → 取最後 time_dim 點
     if (series.size() > static_cast<size_t>(time_dim)) {
@@ -92,60 +152,13 @@ int main(int argc, char* argv[]) {
         std::cout << "Input longer than "<<time_dim<<" → truncated to last "<<time_dim<<" points\n";
     }
 
-    // 若資料不足 → 報錯
-    if (series.size() != static_cast<size_t>(time_dim)) {
-        std::cerr << "CSV length ("<<series.size()<<") != model time dimension ("<<time_dim<<")\n";
-        return 1;
-    }
-
-    // 寫入 Tensor
-    if (in_tensor->type == kTfLiteFloat32) {
-        float* in = interpreter->typed_tensor<float>(in_idx);
-        std::copy(series.begin(), series.end(), in);
-    } else { // int8 量化
-        int8_t* in = interpreter->typed_tensor<int8_t>(in_idx);
-        float scale = in_tensor->params.scale;
-        int32_t zp  = in_tensor->params.zero_point;
-        for (int t = 0; t < time_dim; ++t) {
-            int32_t q = static_cast<int32_t>(std::round(series[t] / scale) + zp);
-            q = std::min<int32_t>(std::max<int32_t>(q, std::numeric_limits<int8_t>::min()),
-                                  std::numeric_limits<int8_t>::max());
-            in[t] = static_cast<int8_t>(q);
-        }
-    }
-
     /* ------------------------------------------------------------- *
-     * 4) 推論                                                        *
+     * 4) 推論，5) 找最大 softmax 機率 (長度不符時報錯)              *
      * ------------------------------------------------------------- */
-    if (interpreter->Invoke() != kTfLiteOk) { std::cerr << "Invoke failed\n"; return 1; }
-
-    /* ------------------------------------------------------------- *
-     * 5) 解析輸出，找最大 softmax 機率                                *
-     * ------------------------------------------------------------- */
-    const int out_idx = interpreter->outputs()[0];
-    TfLiteTensor* out_tensor = interpreter->tensor(out_idx);
-
-    std::vector<float> probs;
-    if (out_tensor->type == kTfLiteFloat32) {
-        const float* out = interpreter->typed_tensor<float>(out_idx);
-        probs.assign(out, out + out_tensor->dims->data[out_tensor->dims->size - 1]);
-    } else if (out_tensor->type == kTfLiteInt8) {
-        const int8_t* out = interpreter->typed_tensor<int8_t>(out_idx);
-        float scale = out_tensor->params.scale;
-        int32_t zp  = out_tensor->params.zero_point;
-        int num_cls = out_tensor->dims->data[out_tensor->dims->size - 1];
-        probs.reserve(num_cls);
-        for (int i = 0; i < num_cls; ++i)
-            probs.push_back((static_cast<int32_t>(out[i]) - zp) * scale);
-    } else {
-        std::cerr << "Unsupported output type\n"; return 1;
-    }
-
-    int   pred_class = 0;
-    float pred_prob  = probs[0];
-    for (size_t i = 1; i < probs.size(); ++i) {
-        if (probs[i] > pred_prob) { pred_prob = probs[i]; pred_class = static_cast<int>(i); }
-    }
+    std::vector<float> probs(classifier.num_classes());
+    const int pred_class = classifier.classify(series, probs);
+    if (pred_class < 0) return 1;
+    const float pred_prob = probs[pred_class];
 
     /* ------------------------------------------------------------- *
      * 6) 輸出結果                                                    *
@@ -154,5 +167,6 @@ int main(int argc, char* argv[]) {
     std::cout << "Prediction  : class = " << pred_class
               << ", prob = " << pred_prob << '\n'
               << "Saved to    : " << output_path << '\n';
+    if (startup_report) print_startup_report(t_main);
     return 0;
 }
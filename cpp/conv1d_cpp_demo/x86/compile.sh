@@ -3,9 +3,21 @@
 CPP_FILE="main.cpp"
 OUT_FILE="run_model"
 
+# ./compile.sh static：只註冊模型用到的 op (MinimalOpResolver) 並靜態連結，輸出 run_model_static，
+# 執行時不需 libtensorflow-lite.so。需先以 -DBUILD_SHARED_LIBS=OFF 建 TFLite 到 build-static
+if [ "$1" == "static" ]; then
+  STATIC_DIR=$HOME/tensorflow/build-static
+  g++ -std=c++17 -O2 -DTFLITE_MINIMAL_OPS $CPP_FILE -o "${OUT_FILE}_static" \
+    -I$HOME/tensorflow                 \
+    -I$STATIC_DIR/flatbuffers/include  \
+    -Wl,--gc-sections -Wl,--start-group $(find "$STATIC_DIR" -name '*.a') -Wl,--end-group \
+    -static -lpthread -ldl
+  exit $?
+fi
+
 # 共享庫 libtensorflow-lite.so 需在當前資料夾
 g++ -std=c++17 $CPP_FILE -o "${OUT_FILE}" \
   -I$HOME/tensorflow                 \
   -L$HOME/tensorflow/build-shared    \
   -ltensorflow-lite -lpthread \
-  -Wl,-rpath=.
\ No newline at end of file
+  -Wl,-rpath=.
@@ -0,0 +1,139 @@
+#!/usr/bin/env python3
+# -*- coding: utf-8 -*-
+"""
+從 .tflite 檔產生只註冊模型用到之 builtin op 的 MinimalOpResolver (header)。
+以 -DTFLITE_MINIMAL_OPS 編譯時 tflite_models.h 改用它取代 BuiltinOpResolver，
+用意是靜態連結時不連進未用到的 kernel (大小與啟動時間的效果尚未在實際 TFLite 靜態建置上量測)。
+
+用法 (於 repo 根目錄)：
+    python3 cpp/tools/gen_op_resolver.py cpp/common/ar_dnn_op_resolver.h cpp/ar_dnn_cpp_demo/arm64/*.tflite
+    python3 cpp/tools/gen_op_resolver.py cpp/common/conv1d_op_resolver.h cpp/conv1d_cpp_demo/arm64/*.tflite
+
+只用標準函式庫：直接讀 flatbuffer (Model.operator_codes)，不需 tensorflow / flatbuffers 套件。
+"""
+import os
+import struct
+import sys
+
+# schema.fbs 的 BuiltinOperator 編號 → 名稱 (Register_<名稱>() 即其 kernel)
+BUILTIN_OPS = [
+    "ADD", "AVERAGE_POOL_2D", "CONCATENATION", "CONV_2D", "DEPTHWISE_CONV_2D",
+    "DEPTH_TO_SPACE", "DEQUANTIZE", "EMBEDDING_LOOKUP", "FLOOR", "FULLY_CONNECTED",
+    "HASHTABLE_LOOKUP", "L2_NORMALIZATION", "L2_POOL_2D", "LOCAL_RESPONSE_NORMALIZATION", "LOGISTIC",
+    "LSH_PROJECTION", "LSTM", "MAX_POOL_2D", "MUL", "RELU",
+    "RELU_N1_TO_1", "RELU6", "RESHAPE", "RESIZE_BILINEAR", "RNN",
+    "SOFTMAX", "SPACE_TO_DEPTH", "SVDF", "TANH", "CONCAT_EMBEDDINGS",
+    "SKIP_GRAM", "CALL", "CUSTOM", "EMBEDDING_LOOKUP_SPARSE", "PAD",
+    "UNIDIRECTIONAL_SEQUENCE_RNN", "GATHER", "BATCH_TO_SPACE_ND", "SPACE_TO_BATCH_ND", "TRANSPOSE",
+    "MEAN", "SUB", "DIV", "SQUEEZE", "UNIDIRECTIONAL_SEQUENCE_LSTM",
+    "STRIDED_SLICE", "BIDIRECTIONAL_SEQUENCE_RNN", "EXP", "TOPK_V2", "SPLIT",
+    "LOG_SOFTMAX", "DELEGATE", "BIDIRECTIONAL_SEQUENCE_LSTM", "CAST", "PRELU",
+    "MAXIMUM", "ARG_MAX", "MINIMUM", "LESS", "NEG",
+    "PADV2", "GREATER", "GREATER_EQUAL", "LESS_EQUAL", "SELECT",
+    "SLICE", "SIN", "TRANSPOSE_CONV", "SPARSE_TO_DENSE", "TILE",
+    "EXPAND_DIMS", "EQUAL", "NOT_EQUAL", "LOG", "SUM",
+    "SQRT", "RSQRT", "SHAPE", "POW", "ARG_MIN",
+    "FAKE_QUANT", "REDUCE_PROD", "REDUCE_MAX", "PACK", "LOGICAL_OR",
+    "ONE_HOT", "LOGICAL_AND", "LOGICAL_NOT", "UNPACK", "REDUCE_MIN",
+    "FLOOR_DIV", "REDUCE_ANY", "SQUARE", "ZEROS_LIKE", "FILL",
+    "FLOOR_MOD", "RANGE", "RESIZE_NEAREST_NEIGHBOR", "LEAKY_RELU", "SQUARED_DIFFERENCE",
+    "MIRROR_PAD", "ABS", "SPLIT_V", "UNIQUE", "CEIL",
+    "REVERSE_V2", "ADD_N", "GATHER_ND", "COS", "WHERE",
+    "RANK", "ELU", "REVERSE_SEQUENCE", "MATRIX_DIAG", "QUANTIZE",
+    "MATRIX_SET_DIAG", "ROUND", "HARD_SWISH", "IF", "WHILE",
+    "NON_MAX_SUPPRESSION_V4", "NON_MAX_SUPPRESSION_V5", "SCATTER_ND", "SELECT_V2", "DENSIFY",
+    "SEGMENT_SUM", "BATCH_MATMUL",
+]
+NOT_REGISTRABLE = {"CUSTOM", "DELEGATE", "CALL"}
+
+
+class Flatbuffer:
+    """只讀 table / vector / scalar 的最小 flatbuffer 解析 (同 dnn_native.h 的 FlatbufferView)"""
+
+    def __init__(self, data):
+        self.b = data
+
+    def u32(self, pos):
+        return struct.unpack_from("<I", self.b, pos)[0]
+
+    def deref(self, pos):
+        return pos + self.u32(pos)
+
+    def field(self, table, fid):
+        vt = table - struct.unpack_from("<i", self.b, table)[0]
+        vt_size = struct.unpack_from("<H", self.b, vt)[0]
+        if 4 + 2 * fid >= vt_size:
+            return None
+        off = struct.unpack_from("<H", self.b, vt + 4 + 2 * fid)[0]
+        return table + off if off else None
+
+    def scalar(self, table, fid, fmt, default):
+        pos = self.field(table, fid)
+        return struct.unpack_from(fmt, self.b, pos)[0] if pos is not None else default
+
+    def tables(self, table, fid):
+        pos = self.field(table, fid)
+        if pos is None:
+            return []
+        vec = self.deref(pos)
+        return [self.deref(vec + 4 + 4 * i) for i in range(self.u32(vec))]
+
+
+def model_ops(path):
+    """回傳 {op 名稱: 最大版本}"""
+    with open(path, "rb") as f:
+        data = f.read()
+    if len(data) < 8 or data[4:8] != b"TFL3":
+        sys.exit("%s: not a TFLite flatbuffer" % path)
+    fb = Flatbuffer(data)
+    model = fb.deref(0)
+    ops = {}
+    for code in fb.tables(model, 1):                               # Model.operator_codes
+        # builtin_code (新欄位) 與 deprecated_builtin_code 取較大者，同 TFLite 的 GetBuiltinCode
+        builtin = max(fb.scalar(code, 0, "<b", 0), fb.scalar(code, 3, "<i", 0))
+        version = fb.scalar(code, 2, "<i", 1)
+        if builtin >= len(BUILTIN_OPS):
+            sys.exit("%s: builtin op %d is not in BUILTIN_OPS, add it from schema.fbs" % (path, builtin))
+        name = BUILTIN_OPS[builtin]
+        if name in NOT_REGISTRABLE:
+            sys.exit("%s: %s op cannot be registered by a builtin resolver" % (path, name))
+        ops[name] = max(ops.get(name, 1), version)
+    return ops
+
+
+def main():
+    if len(sys.argv) < 3:
+        sys.exit("usage: gen_op_resolver.py OUT.h MODEL.tflite [MODEL.tflite ...]")
+    out_path, models = sys.argv[1], sys.argv[2:]
+    ops = {}
+    for m in models:
+        for name, ver in model_ops(m).items():
+            ops[name] = max(ops.get(name, 1), ver)
+
+    lines = [
+        "#pragma once",
+        "//------------------------------------------------------------",
+        "// 由 cpp/tools/gen_op_resolver.py 產生，請勿手動修改。來源模型：",
+    ]
+    lines += ["//   %s" % os.path.basename(m) for m in models]
+    lines += [
+        "// 只註冊上述模型用到的 builtin op；以 -DTFLITE_MINIMAL_OPS 編譯時取代 BuiltinOpResolver",
+        "//------------------------------------------------------------",
+        '#include "tensorflow/lite/kernels/builtin_op_kernels.h"',
+        '#include "tensorflow/lite/mutable_op_resolver.h"',
+        "",
+        "class MinimalOpResolver : public tflite::MutableOpResolver {",
+        "public:",
+        "    MinimalOpResolver() {",
+    ]
+    for name in sorted(ops):
+        lines.append("        AddBuiltin(tflite::BuiltinOperator_%s, tflite::ops::builtin::Register_%s(), 1, %d);"
+                     % (name, name, ops[name]))
+    lines += ["    }", "};", ""]
+    with open(out_path, "w") as f:
+        f.write("\n".join(lines))
+    print("%s: %s" % (out_path, ", ".join("%s (v%d)" % (n, ops[n]) for n in sorted(ops))))
+
+
+if __name__ == "__main__":
+    main()
@@ -0,0 +1,82 @@
+#!/bin/bash
+# 比較多個 run_model 建置 (例如動態連結版與 static 模式建出的 run_model_static) 的
+# 冷啟動時間、部署大小與峰值 RSS，每個執行檔一列。
+#
+# 用法：startup_report.sh [-n 次數] -b <執行檔> [-b <執行檔> ...] -- <run_model 參數>
+#   例 (AR-DNN 勿加 --engine=native/auto，原生引擎不會載入 TFLite)：
+#   ../../tools/startup_report.sh -n 20 -b ./run_model -b ./run_model_static -- \
+#       -m ar_dnn-w10-l16-l32-l16_windfarm_0620.tflite -i input-dnn.csv -o out.csv \
+#       -s ar_dnn-w10-l16-l32-l16_windfarm_0620-std-mean.csv -n 25
+#
+# 欄位：
+#   binary_kb  執行檔大小
+#   libs_kb    ldd 解析到、且不在系統目錄的共享庫總大小 (需一併部署的 .so，例如 lib/*.so)
+#   first_ms   第一次執行的牆鐘時間 (以 root 執行時先清 page cache，才是真正的冷啟動)
+#   median_ms  之後 n 次的牆鐘時間中位數
+#   main_ms    程序自己量的 main() 到完成；與 median_ms 的差距約為載入與動態連結的成本
+#   rss_kb     峰值 RSS (程序以 --startup-report 回報)
+
+set -e
+
+RUNS=10
+BINS=()
+while [ $# -gt 0 ]; do
+    case "$1" in
+        -n) RUNS="$2"; shift 2 ;;
+        -b) BINS+=("$2"); shift 2 ;;
+        --) shift; break ;;
+        *)  echo "Unknown option: $1" >&2; exit 1 ;;
+    esac
+done
+if [ ${#BINS[@]} -eq 0 ]; then
+    echo "Usage: $0 [-n runs] -b <run_model> [-b <run_model_static> ...] -- <run_model args>" >&2
+    exit 1
+fi
+
+# 微秒時間戳：bash 5 有 EPOCHREALTIME (不需 fork)，否則用 date
+now_us() {
+    if [ -n "${EPOCHREALTIME:-}" ]; then echo "${EPOCHREALTIME/[.,]/}"; else echo $(( $(date +%s%N) / 1000 )); fi
+}
+
+file_kb() { echo $(( ($(stat -c %s "$1") + 1023) / 1024 )); }
+
+# 不在系統目錄的共享庫總大小 (靜態執行檔 ldd 會失敗，視為 0)
+libs_kb() {
+    local total=0 lib
+    for lib in $(ldd "$1" 2>/dev/null | awk '/=>/ && $3 ~ /^\// {print $3}'); do
+        case "$lib" in
+            /lib/*|/lib64/*|/usr/lib/*|/usr/lib64/*) ;;
+            *) total=$(( total + $(file_kb "$lib") )) ;;
+        esac
+    done
+    echo $total
+}
+
+# 執行一次，輸出 "牆鐘微秒 main_ms rss_kb"
+run_once() {
+    local bin="$1"; shift
+    local t0 t1 out
+    t0=$(now_us)
+    out=$("$bin" "$@" --startup-report 2>/dev/null) || { echo "$bin failed" >&2; exit 1; }
+    t1=$(now_us)
+    local line
+    line=$(echo "$out" | grep '^startup_report:' | tail -n 1)
+    local main_ms rss_kb
+    main_ms=$(echo "$line" | sed -n 's/.*main_ms=\([0-9.e+-]*\).*/\1/p')
+    rss_kb=$(echo "$line" | sed -n 's/.*peak_rss_kb=\([0-9]*\).*/\1/p')
+    echo "$(( t1 - t0 )) ${main_ms:-?} ${rss_kb:-?}"
+}
+
+printf "%-28s %10s %10s %10s %10s %10s %10s\n" binary binary_kb libs_kb first_ms median_ms main_ms rss_kb
+for bin in "${BINS[@]}"; do
+    if [ -w /proc/sys/vm/drop_caches ]; then sync; echo 3 > /proc/sys/vm/drop_caches; fi
+    read -r first_us _ _ < <(run_once "$bin" "$@")
+    walls=()
+    for (( i = 0; i < RUNS; ++i )); do
+        read -r us main_ms rss_kb < <(run_once "$bin" "$@")
+        walls+=("$us")
+    done
+    median_us=$(printf "%s\n" "${walls[@]}" | sort -n | awk '{a[NR]=$1} END {print (NR%2 ? a[(NR+1)/2] : (a[NR/2]+a[NR/2+1])/2)}')
+    printf "%-28s %10s %10s %10.2f %10.2f %10s %10s\n" "$(basename "$bin")" "$(file_kb "$bin")" "$(libs_kb "$bin")" \
+        "$(awk -v u="$first_us" 'BEGIN{print u/1000}')" "$(awk -v u="$median_us" 'BEGIN{print u/1000}')" "$main_ms" "$rss_kb"
+done